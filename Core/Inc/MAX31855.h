@@ -11,6 +11,7 @@
 #include "stm32f0xx_hal.h"
 #include "main.h"
 #include "arm_math.h"
+#include "spibus.h"
 
 #define MAX31855_PAYLOAD_LENGTH  32
 #define MAX31855_TIMEOUT  1000000
@@ -59,6 +60,7 @@ typedef union {
 typedef struct
 {
     SPI_HandleTypeDef* hspi;
+    Spibus_HandleTypeDef_t* hbus; //NULL if the sensor has the bus for itself
     uint8_t raw_payload[4];
     max31855_payload_t payload;
     //max31855_data_union_t data;
@@ -66,6 +68,7 @@ typedef struct
 }MAX31855_HandleTypeDef_t;
 
 HAL_StatusTypeDef max31855_init(MAX31855_HandleTypeDef_t* hmax31855, SPI_HandleTypeDef* hspi);
+void max31855_attach_bus(MAX31855_HandleTypeDef_t* hmax31855, Spibus_HandleTypeDef_t* hbus);
 void max_31855_print_max31855_payload_binary(MAX31855_HandleTypeDef_t* hmax31855);
 void max_31855_print_payload(MAX31855_HandleTypeDef_t *hmax31855);
 HAL_StatusTypeDef max31855_read_data(MAX31855_HandleTypeDef_t *hmax31855);
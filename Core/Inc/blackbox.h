@@ -0,0 +1,98 @@
+/*
+ * blackbox.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_BLACKBOX_H_
+#define INC_BLACKBOX_H_
+
+#include "stm32f0xx_hal.h"
+#include "main.h"
+#include "heater.h"
+#include "firing.h"
+
+/*
+ * Black box recorder of the last BLACKBOX_LENGTH control steps.
+ *
+ * The ring lives in the .noinit RAM region (see linker script), the startup code
+ * does not touch it, so it survives every reset but a power cycle. Every record
+ * carries a check byte from the hardware CRC unit, the header has a magic number
+ * and its own CRC. initBlackbox validates the ring and keeps recording after the
+ * records from before the reset, a BOOT event with the reset flags marks the reset.
+ *
+ * Usage:
+ * blackbox_on_interupt needs to be called every RTC interrupt after heater_on_interupt,
+ * it writes one record at the end of every pid window. Nothing is recorded while
+ * a kiln model is attached to the heater. blackbox_dump prints the ring
+ * oldest first as CSV:
+ *      BB,<time s>,<temperature>,<setpoint>,<slope>,<p>,<i>,<d>,<level>,<flags>,<segment>,<event>
+ */
+
+#define BLACKBOX_LENGTH 48
+#define BLACKBOX_MAGIC 0x4B4C4E42U
+
+//flags of a record, low nibble. High nibble is the program segment
+#define BLACKBOX_FLAG_DOOR_OPEN  0x01
+#define BLACKBOX_FLAG_TC_FAULT   0x02
+#define BLACKBOX_FLAG_CONTROL    0x04
+#define BLACKBOX_FLAG_ESTIMATING 0x08
+
+//event since last record
+typedef enum
+{
+    BLACKBOX_EVENT_NONE = 0,
+    BLACKBOX_EVENT_BOOT = 1,         //level holds the reset flags of RCC_CSR
+    BLACKBOX_EVENT_FIRING_START = 2,
+    BLACKBOX_EVENT_FIRING_STOP = 3,
+    BLACKBOX_EVENT_SEGMENT = 4,
+    BLACKBOX_EVENT_TC_FAULT = 5
+}blackbox_event_t;
+
+//one control step, 20 bytes without padding, read as 5 words for the CRC
+typedef struct
+{
+    uint32_t time;        //[s] since boot
+    int16_t temperature;  //[C/16] mean of pid window
+    int16_t setpoint;     //[C/16]
+    int16_t slope;        //[C/h]
+    int16_t p_term;       //[levels/16]
+    int16_t i_term;       //[levels/16]
+    int16_t d_term;       //[levels/16]
+    uint8_t level;
+    uint8_t flags;
+    uint8_t event;        //blackbox_event_t
+    uint8_t check;        //low byte of CRC32 over the record without this byte
+}blackbox_record_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t head;        //next record to write
+    uint16_t count;       //valid records
+    uint32_t crc;         //over magic, head and count
+    blackbox_record_t records[BLACKBOX_LENGTH];
+}blackbox_ring_t;
+
+typedef struct
+{
+    blackbox_ring_t* ring;
+    uint16_t recovered;   //valid records found at boot
+    uint8_t reset_flags;  //RCC_CSR reset flags of last reset
+    uint32_t time;        //[s] since boot
+    uint16_t last_window;
+    firing_mode_t last_mode;
+    uint8_t last_segment;
+    uint8_t last_fault;
+    uint8_t pending_event;
+
+    Heater_HandleTypeDef_t* hheater;
+    Firing_HandleTypeDef_t* hfiring;
+}Blackbox_HandleTypeDef_t;
+
+HAL_StatusTypeDef initBlackbox(Blackbox_HandleTypeDef_t* hbb, Heater_HandleTypeDef_t* hheater, Firing_HandleTypeDef_t* hfiring);
+void blackbox_on_interupt(Blackbox_HandleTypeDef_t* hbb);
+void blackbox_dump(Blackbox_HandleTypeDef_t* hbb);
+
+#endif /* INC_BLACKBOX_H_ */
@@ -0,0 +1,53 @@
+/*
+ * console.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_CONSOLE_H_
+#define INC_CONSOLE_H_
+
+#include "stm32f0xx_hal.h"
+
+/*
+ * Line based command console on the log uart.
+ *
+ * Usage:
+ * initConsole starts receiving byte by byte in interrupt mode,
+ * console_on_receive needs to be called from HAL_UART_RxCpltCallback,
+ * console_on_error from HAL_UART_ErrorCallback and
+ * console_process from the main loop, it executes a finished line.
+ *
+ * Commands:
+ *  log                        prints the level mask of all channels
+ *  log <channel|all> <level>  enables level and above: debug, info, warning, error, off
+ *  log <channel|all> 0x<mask> sets mask of enabled levels, bit n is level n
+ *  dump                       sends the last firing from the flash log
+ *  blackbox                   prints the control steps recorded before the last reset
+ *  sim <acceleration|off>     dry run on the kiln model, coils stay off
+ *  pool                       prints use of the block pools
+ *  dma                        prints transfers and utilisation of the DMA channels
+ *  cycle                      prints heater cycle time per temperature band and relay operations
+ *  shadow [<kp> <ki> <kd>|off] shadow controller with candidate gains, prints statistics
+ *  bench                      cycles of the window kernels, flash against RAM
+ */
+
+#define CONSOLE_LINE_LENGTH 32
+#define CONSOLE_MAX_ARGS 4
+
+typedef struct
+{
+    UART_HandleTypeDef* huart;
+    uint8_t rx_byte;
+    char line[CONSOLE_LINE_LENGTH];
+    uint8_t length;
+    volatile uint8_t line_ready; //receiving pauses until the line is processed
+}Console_HandleTypeDef_t;
+
+HAL_StatusTypeDef initConsole(Console_HandleTypeDef_t* hconsole, UART_HandleTypeDef* huart);
+void console_on_receive(Console_HandleTypeDef_t* hconsole);
+void console_on_error(Console_HandleTypeDef_t* hconsole);
+void console_process(Console_HandleTypeDef_t* hconsole);
+
+#endif /* INC_CONSOLE_H_ */
@@ -0,0 +1,73 @@
+/*
+ * cycletime.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_CYCLETIME_H_
+#define INC_CYCLETIME_H_
+
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+#include "heater.h"
+
+/*
+ * Optimiser of the heater cycle time (pwm on and off time, slot of the balanced allocation).
+ *
+ * Short cycles control finely but wear the relays, long cycles let the temperature ripple.
+ * Switching one coil changes the heating by 2 levels, so a cycle of t seconds ripples
+ * by about 2 * response * t, response being the heating rate one level adds [C/s].
+ * The response is measured per temperature band: at the end of a pid window in which the
+ * level differs from the window before, the change of slope over the change of level is
+ * averaged into the band of the window mean.
+ *
+ * The cycle time of a band is the longest that keeps the ripple within CYCLETIME_RIPPLE,
+ * but never shorter than what keeps the measured relay operations within
+ * CYCLETIME_RELAY_BUDGET, relay life goes first. Operations scale with 1 / cycle time, so
+ * rate * cycle time is averaged and the cycle that meets the budget is that average / budget.
+ * The cycle is a divisor of the pid interval, so every pid window holds whole cycles: a new
+ * level takes effect within the window after it was set and a window delivers what its
+ * level demands. The budget can therefore not always be met with short pid intervals.
+ * The result is handed to heater_set_cycle_time, which switches at the next edge.
+ *
+ * Usage:
+ * cycletime_on_interupt needs to be called every RTC interrupt after heater_on_interupt,
+ * it counts relay operations and updates once per pid window. The cycle time is only
+ * changed while the heater runs closed loop control.
+ */
+
+#define CYCLETIME_BANDS 4
+#define CYCLETIME_BAND_HYSTERESIS 10.0f //[C] around band limits
+#define CYCLETIME_RIPPLE 1.0f           //[C] peak to peak ripple bound
+#define CYCLETIME_RELAY_BUDGET 300U     //[operations/h] all coils, 100k per relay in 1000 firing hours
+#define CYCLETIME_DEFAULT_RESPONSE 0.02f //[C/s per level] until measured
+#define CYCLETIME_RESPONSE_WEIGHT 8     //averaging of response, 1/weight per measurement
+#define CYCLETIME_RATE_WEIGHT 16        //averaging of operation rate per pid window
+#define CYCLETIME_MIN_SECONDS 2
+#define CYCLETIME_MAX_SECONDS 30
+
+typedef struct
+{
+    float32_t response[CYCLETIME_BANDS]; //[C/s per level]
+    uint8_t window[CYCLETIME_BANDS];     //[s] cycle time chosen for band
+    uint8_t band;                 //band of the last window mean
+    uint32_t op_rate;             //[operations/h] averaged
+    uint32_t op_cycle;            //[operations/h * s] averaged rate times cycle time
+    uint16_t ops;                 //relay operations in current pid window
+    uint16_t ticks;               //[s] of current pid window
+    uint8_t last_outputs;
+    uint8_t level;                //heater level of current pid window
+    uint8_t prev_level;           //heater level of the window before
+    float32_t prev_slope;         //[C/h] slope of the window before
+    uint8_t prev_valid;
+    uint16_t last_window;         //window count of the heater at last update
+
+    Heater_HandleTypeDef_t* hheater;
+}Cycletime_HandleTypeDef_t;
+
+HAL_StatusTypeDef initCycletime(Cycletime_HandleTypeDef_t* hct, Heater_HandleTypeDef_t* hheater);
+void cycletime_on_interupt(Cycletime_HandleTypeDef_t* hct);
+void cycletime_print_stats(Cycletime_HandleTypeDef_t* hct);
+
+#endif /* INC_CYCLETIME_H_ */
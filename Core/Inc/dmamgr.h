@@ -0,0 +1,111 @@
+/*
+ * dmamgr.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_DMAMGR_H_
+#define INC_DMAMGR_H_
+
+#include "stm32f0xx_hal.h"
+
+/*
+ * DMA channel manager for the five channels of DMA1.
+ *
+ * Every peripheral request of the F030x8 can only be served by fixed channels, some
+ * by a second one selected with a SYSCFG remap bit:
+ *      ADC       ch1, ch2 (remap)        SPI2_RX   ch4
+ *      USART1_TX ch2, ch4 (remap)        SPI2_TX   ch5
+ *      USART1_RX ch3, ch5 (remap)        I2C1_TX   ch2
+ *                                        I2C1_RX   ch3
+ * A transfer is submitted for a request and started as soon as the request is idle and
+ * one of its channels is free, otherwise it waits in a queue ordered by priority
+ * (sensor before uart before lcd, in order of submission within a priority). The manager
+ * sets the remap bit, the channel priority and the DMA enable bit of the peripheral, the
+ * peripheral itself has to be configured by its driver. For full duplex SPI submit RX
+ * before TX.
+ *
+ * Finished transfers are collected in the interrupt, their callbacks run from
+ * dmamgr_process in the main loop. Every channel counts transfers, items, errors and
+ * busy time, dmamgr_print_stats prints them with the utilisation since init.
+ *
+ * The log uart sends logWrite (firing dump) through the manager, see log_attach_dma.
+ *
+ * Usage:
+ * initDmamgr, DMA1 interrupt handlers call dmamgr_on_interupt, dmamgr_process in main loop.
+ * The transfer struct belongs to the caller and must stay valid until its callback ran.
+ */
+
+#define DMAMGR_CHANNELS 5
+
+typedef enum
+{
+    DMAMGR_REQ_ADC = 0,
+    DMAMGR_REQ_SPI2_RX,
+    DMAMGR_REQ_SPI2_TX,
+    DMAMGR_REQ_USART1_TX,
+    DMAMGR_REQ_USART1_RX,
+    DMAMGR_REQ_I2C1_TX,
+    DMAMGR_REQ_I2C1_RX,
+    DMAMGR_REQ_COUNT
+}dmamgr_request_t;
+
+//lower is served first
+typedef enum
+{
+    DMAMGR_PRIO_SENSOR = 0,
+    DMAMGR_PRIO_UART = 1,
+    DMAMGR_PRIO_LCD = 2
+}dmamgr_priority_t;
+
+typedef enum
+{
+    DMAMGR_IDLE = 0,
+    DMAMGR_QUEUED,
+    DMAMGR_ACTIVE,
+    DMAMGR_DONE
+}dmamgr_state_t;
+
+typedef void (*dmamgr_callback_t)(void* context, HAL_StatusTypeDef status);
+
+typedef struct dmamgr_transfer_t
+{
+    dmamgr_request_t request;
+    dmamgr_priority_t priority;
+    void* buffer;
+    uint16_t length;            //items
+    uint8_t width;              //bytes per item, 1 or 2
+    dmamgr_callback_t callback; //optional, runs from dmamgr_process
+    void* context;
+
+    volatile dmamgr_state_t state;  //set by the manager
+    HAL_StatusTypeDef status;       //HAL_OK or HAL_ERROR on transfer error
+    struct dmamgr_transfer_t* next;
+}dmamgr_transfer_t;
+
+typedef struct
+{
+    dmamgr_transfer_t* active;  //NULL if free
+    uint32_t start_tick;
+    uint32_t transfers;
+    uint32_t items;
+    uint32_t busy_ms;
+    uint16_t errors;
+}dmamgr_channel_t;
+
+typedef struct
+{
+    dmamgr_channel_t channels[DMAMGR_CHANNELS];
+    dmamgr_transfer_t* queue;   //waiting transfers, by priority
+    dmamgr_transfer_t* done;    //finished transfers, callbacks pending
+    uint32_t since;             //tick the counters started
+}Dmamgr_HandleTypeDef_t;
+
+HAL_StatusTypeDef initDmamgr(Dmamgr_HandleTypeDef_t* hdma);
+HAL_StatusTypeDef dmamgr_submit(Dmamgr_HandleTypeDef_t* hdma, dmamgr_transfer_t* transfer);
+void dmamgr_on_interupt(Dmamgr_HandleTypeDef_t* hdma);
+void dmamgr_process(Dmamgr_HandleTypeDef_t* hdma);
+void dmamgr_print_stats(Dmamgr_HandleTypeDef_t* hdma);
+
+#endif /* INC_DMAMGR_H_ */
@@ -10,10 +10,11 @@
 
 #include "stm32f0xx_hal.h"
 #include "log.h"
+#include "pool.h"
 #include <stdio.h>
-#include <stdlib.h>
 
-//#define EVENT_ENABLE_LOG //enable debug output to uart
+//nodes in the event pool, events are dropped when all are queued
+#define EVENT_POOL_BLOCKS 16
 
 
 //Enum for all possible events
@@ -0,0 +1,87 @@
+/*
+ * firestats.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_FIRESTATS_H_
+#define INC_FIRESTATS_H_
+
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+#include "heater.h"
+
+/*
+ * Streaming statistics of a firing, per segment and for the whole firing.
+ *
+ * Every tick firestats_on_tick adds one sample in O(1), all integer:
+ *  tracking error temperature - reference, sum and sum of squares in C/16 for
+ *  mean and variance (exact, both 64 bit), max |error|
+ *  overshoot beyond the segment target in direction of the segment
+ *  time until the temperature first is within FIRESTATS_BAND of the target
+ *  duty cycle and energy from the heater level, FIRESTATS_LEVEL_POWER_W per level
+ *  relay operations (switching edges of the coil outputs) and faults
+ *  (thermocouple fault or door opened)
+ * firestats_summarize turns an accumulator into a compact summary.
+ *
+ * Usage:
+ * firestats_start at firing start, firestats_begin_segment when a segment starts,
+ * firestats_set_target when the target of the running segment changes,
+ * firestats_on_tick every tick of closed loop control. The firing takes the summary
+ * of a segment before it begins the next and the one of the firing when it ends,
+ * the firing summary is kept in last for the display.
+ */
+
+#define FIRESTATS_BAND 2                //[C] target counts as reached
+#define FIRESTATS_LEVEL_POWER_W 1000    //[W] heating power of one level (half a coil)
+#define FIRESTATS_NOT_REACHED 0xFFFF
+
+typedef struct
+{
+    uint32_t n;              //ticks
+    int64_t sum;             //[C/16] sum of tracking errors
+    int64_t sum_sq;          //[(C/16)^2] sum of squared tracking errors
+    uint16_t max_error;      //[C/16] max |tracking error|
+    int16_t overshoot;       //[C/16] max beyond target, negative if never reached
+    uint16_t time_to_target; //[s] FIRESTATS_NOT_REACHED if never within band
+    uint32_t level_sum;      //[level * s]
+    uint16_t relay_ops;
+    uint8_t faults;
+}firestats_acc_t;
+
+typedef struct
+{
+    int16_t mean_error;      //[C/16]
+    uint16_t sd_error;       //[C/16] standard deviation
+    uint16_t max_error;      //[C/16]
+    int16_t overshoot;      //[C/16] 0 if never reached
+    uint16_t time_to_target; //[s]
+    uint16_t duty;           //[1/1000]
+    uint16_t energy;         //[Wh]
+    uint16_t relay_ops;
+    uint8_t faults;
+}firestats_summary_t;
+
+typedef struct
+{
+    firestats_acc_t segment;
+    firestats_acc_t firing;
+    int16_t target;          //[C/16] of current segment
+    int8_t direction;        //1 heating segment, -1 cooling
+    uint32_t target_tick;    //segment tick the target was set, time to target counts from it
+    uint8_t last_outputs;    //coil outputs of last tick
+    uint8_t last_fault;      //fault or door of last tick
+    firestats_summary_t last; //summary of the last firing
+
+    Heater_HandleTypeDef_t* hheater;
+}Firestats_HandleTypeDef_t;
+
+HAL_StatusTypeDef initFirestats(Firestats_HandleTypeDef_t* hstats, Heater_HandleTypeDef_t* hheater);
+void firestats_start(Firestats_HandleTypeDef_t* hstats);
+void firestats_begin_segment(Firestats_HandleTypeDef_t* hstats, float32_t from, float32_t target);
+void firestats_set_target(Firestats_HandleTypeDef_t* hstats, float32_t from, float32_t target);
+void firestats_on_tick(Firestats_HandleTypeDef_t* hstats, float32_t reference);
+void firestats_summarize(const firestats_acc_t* acc, firestats_summary_t* summary);
+
+#endif /* INC_FIRESTATS_H_ */
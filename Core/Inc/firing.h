@@ -0,0 +1,124 @@
+/*
+ * firing.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_FIRING_H_
+#define INC_FIRING_H_
+
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+#include "heater.h"
+#include "pid.h"
+#include "scheduler.h"
+#include "flashlog.h"
+#include "loadest.h"
+#include "heatwork.h"
+#include "firestats.h"
+
+//max rate the reference moves towards a hold target [C/h]
+#define FIRING_HOLD_MAX_RATE 150.0f
+//max segments of a program
+#define FIRING_MAX_SEGMENTS 10
+
+/*
+ * Usage:
+ * a firing owns the reference temperature the heater controls to.
+ * firing_on_interupt needs to be called every RTC interrupt before heater_on_interupt,
+ * it moves the reference and hands it to the heater.
+ *
+ * Hold mode: firing_start_hold starts at the current temperature and ramps the
+ * reference with max_rate towards the target, then holds it. firing_set_target
+ * changes the target while running, the reference keeps ramping from where it is
+ * so target changes are bumpless.
+ *
+ * Program mode: firing_start_program runs a list of segments. Each segment ramps the
+ * reference with its gradient to its target and holds it there for hold minutes,
+ * a gradient of 0 steps the reference. A segment with a cone finishes its hold as soon
+ * as the heat work of the firing reaches the cone, hold is then the longest it holds.
+ * The planned end of every segment is kept in
+ * segment_end. firing_edit_segment changes the current or a future segment while
+ * running: the reference and the pid state are left as they are, so the change is
+ * bumpless, and the plan is only recomputed from the edited segment on.
+ *
+ * With a load estimator attached (firing_attach_loadest) a program that starts by
+ * heating first measures the load, see loadest.h. The gains are then scaled with the
+ * load factor and ramps get a feed forward of gradient * feed forward gain levels,
+ * so the pid only has to correct the remaining error. Without an estimate no feed
+ * forward is used.
+ *
+ * With a log attached (firing_attach_log) every firing is recorded to flash,
+ * one sample per heater log interval.
+ *
+ * With statistics attached (firing_attach_stats) every tick of closed loop control is
+ * added to the statistics, see firestats.h. Each segment (a hold is one segment) and the
+ * whole firing end with a summary in the log, the one of the firing stays in the
+ * statistics for the display.
+ */
+
+typedef enum
+{
+    FIRING_IDLE = 0,
+    FIRING_HOLD = 1,
+    FIRING_PROGRAM = 2
+}firing_mode_t;
+
+typedef struct
+{
+    uint16_t gradient;    //[C/h] rate of the ramp, 0 steps to target
+    uint16_t target;      //[C]
+    uint16_t hold;        //[min] time at target before next segment
+    uint8_t cone;         //0 for a timed hold, else hold ends early at heat work of cone
+}firing_segment_t;
+
+typedef struct
+{
+    firing_mode_t mode;
+    float32_t target;     //[C] temperature to reach and hold
+    float32_t reference;  //[C] current setpoint for the pid
+    float32_t max_rate;   //[C/h] max rate of the reference
+    uint8_t dashboard_dirty; //new values for the dashboard
+    uint32_t elapsed;     //[s] since firing start
+    uint8_t log_counter;  //[s] since last logged sample
+
+    firing_segment_t segments[FIRING_MAX_SEGMENTS]; //program, only in program mode
+    uint32_t segment_end[FIRING_MAX_SEGMENTS];      //[s] planned end since firing start
+    uint8_t length;       //segments in program
+    uint8_t segment;      //current segment
+    uint32_t hold_time;   //[s] current segment spent at target
+    Heatwork_HandleTypeDef_t heatwork; //since firing start
+
+    uint8_t estimating;   //load estimation runs before the first segment
+    float32_t k_p;        //gains for a nominal load
+    float32_t k_i;
+    float32_t k_d;
+    float32_t feedforward_gain; //[levels per C/h] 0 without load estimator
+
+    Heater_HandleTypeDef_t* hheater;
+    PID_HandletypeDef_t* hpid;
+    Scheduler_HandleTypeDef_t* hsched;
+    Flashlog_HandleTypeDef_t* hlog;      //optional, NULL if not attached
+    Loadest_HandleTypeDef_t* hload;      //optional, NULL if not attached
+    Firestats_HandleTypeDef_t* hstats;   //optional, NULL if not attached
+}Firing_HandleTypeDef_t;
+
+HAL_StatusTypeDef initFiring(Firing_HandleTypeDef_t* hfiring, Heater_HandleTypeDef_t* hheater,
+        PID_HandletypeDef_t* hpid, Scheduler_HandleTypeDef_t* hsched);
+void firing_attach_log(Firing_HandleTypeDef_t* hfiring, Flashlog_HandleTypeDef_t* hlog);
+void firing_attach_loadest(Firing_HandleTypeDef_t* hfiring, Loadest_HandleTypeDef_t* hload);
+void firing_attach_stats(Firing_HandleTypeDef_t* hfiring, Firestats_HandleTypeDef_t* hstats);
+HAL_StatusTypeDef firing_start_hold(Firing_HandleTypeDef_t* hfiring, float32_t target,
+        float32_t k_p, float32_t k_i, float32_t k_d);
+HAL_StatusTypeDef firing_start_program(Firing_HandleTypeDef_t* hfiring, const firing_segment_t* segments,
+        uint8_t length, float32_t k_p, float32_t k_i, float32_t k_d);
+HAL_StatusTypeDef firing_edit_segment(Firing_HandleTypeDef_t* hfiring, uint8_t index, const firing_segment_t* segment);
+uint32_t firing_get_remaining(Firing_HandleTypeDef_t* hfiring);
+HAL_StatusTypeDef firing_set_target(Firing_HandleTypeDef_t* hfiring, float32_t target);
+HAL_StatusTypeDef firing_stop(Firing_HandleTypeDef_t* hfiring);
+uint8_t firing_is_running(Firing_HandleTypeDef_t* hfiring);
+uint8_t firing_take_dashboard_update(Firing_HandleTypeDef_t* hfiring);
+void firing_on_interupt(Firing_HandleTypeDef_t* hfiring);
+
+#endif /* INC_FIRING_H_ */
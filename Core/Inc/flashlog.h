@@ -0,0 +1,164 @@
+/*
+ * flashlog.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_FLASHLOG_H_
+#define INC_FLASHLOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stm32f0xx_hal.h"
+
+/*
+ * Append-only firing log on NOR flash (W25Qxx or the file backed stand-in).
+ *
+ * Layout:
+ *  0x00000 - 0x0FFFF  index block, 16 byte index entries written in sequence,
+ *                     circular over its 4K sectors, a sector is erased just before its first entry
+ *  0x10000 - end      data, 16 byte records, 16 per 256 byte page so a record never
+ *                     crosses a page. Circular over 64K blocks, a block is erased just before
+ *                     its first record
+ *
+ * Index entries mark the start and end of every firing and the start of every data
+ * block. Each entry has a sequence number, so the boot recovery reads the first entry
+ * of each index sector, binary searches the newest sector for its last entry and then
+ * binary searches the data block that entry points to for the write position. This
+ * bounds the scan to a few dozen reads independent of the flash size.
+ *
+ * Usage:
+ * initFlashlog with a device, flashlog_start_firing / flashlog_end_firing around a firing,
+ * flashlog_append for every record (interrupt safe, queued) and flashlog_process
+ * frequently from the main loop, it does all flash writes and erases.
+ */
+
+#define FLASHLOG_PAGE_SIZE 256
+#define FLASHLOG_SECTOR_SIZE 4096
+#define FLASHLOG_BLOCK_SIZE 65536
+#define FLASHLOG_INDEX_SIZE FLASHLOG_BLOCK_SIZE
+#define FLASHLOG_DATA_START FLASHLOG_INDEX_SIZE
+//records waiting in RAM for flashlog_process, fits the segments of a program start
+#define FLASHLOG_QUEUE_LENGTH 16
+
+#define FLASHLOG_ERASED_SEQ 0xFFFFFFFFU
+#define FLASHLOG_NO_ADDR 0xFFFFFFFFU
+#define FLASHLOG_ERASED_ID 0xFFFF
+
+/*
+ * types of index entries
+ */
+typedef enum
+{
+    FLASHLOG_INDEX_START = 1, //firing started at addr
+    FLASHLOG_INDEX_MARK = 2,  //data block starting at addr gets written next
+    FLASHLOG_INDEX_END = 3    //firing ended, addr is the first free address
+}flashlog_index_type_t;
+
+/*
+ * types of data records, START/END only pass through the queue
+ */
+typedef enum
+{
+    FLASHLOG_REC_SAMPLE = 1,  //periodic control sample, data the firing mode in bits 0..7
+                              //and the phase imbalance [%] in bits 8..15
+    FLASHLOG_REC_EVENT = 2,   //event, data holds event specific value
+    FLASHLOG_REC_SUMMARY = 3, //statistics of a segment or the firing as two records (see firestats.h),
+                              //level is the segment index or FLASHLOG_SUMMARY_FIRING.
+                              //first: temperature the mean tracking error, setpoint its deviation,
+                              //slope the max error [C/16], data the time to target [s].
+                              //second, level | FLASHLOG_SUMMARY_SECOND: temperature the overshoot [C/16],
+                              //setpoint the energy [Wh], slope the relay operations, data the duty
+                              //[1/1000] in bits 0..9 and the faults in bits 10..15
+    FLASHLOG_REC_SEGMENT = 4, //program segment as started or edited, level is the index,
+                              //temperature the target, slope the gradient, data the hold [min]
+                              //in bits 0..10 and the finishing cone in bits 11..15
+    FLASHLOG_REC_LOAD = 5,    //load estimate, level is the class, slope the measured slope,
+                              //data the load factor [1/100]
+    FLASHLOG_REC_CONE = 6,    //heat work of a cone reached, level is the cone (see heatwork.h)
+    FLASHLOG_REC_START = 0xF0,
+    FLASHLOG_REC_END = 0xF1
+}flashlog_record_type_t;
+
+#define FLASHLOG_SUMMARY_FIRING 0x0F //summary level of the whole firing
+#define FLASHLOG_SUMMARY_SECOND 0x80 //summary level flag of the second record
+#define FLASHLOG_SUMMARY_MAX_FAULTS 63
+
+typedef struct __attribute__((packed))
+{
+    uint32_t seq;          //sequence number, FLASHLOG_ERASED_SEQ if erased
+    uint8_t type;          //flashlog_index_type_t
+    uint8_t check;         //xor over all other bytes, detects torn writes and partial erases
+    uint16_t firing_id;
+    uint32_t addr;         //data address, see type
+    uint32_t start_addr;   //data address of the firing start
+}flashlog_index_t;
+
+typedef struct __attribute__((packed))
+{
+    uint16_t firing_id;    //FLASHLOG_ERASED_ID if erased
+    uint8_t type;          //flashlog_record_type_t
+    uint8_t level;         //heater level
+    uint32_t time;         //[s] since firing start
+    int16_t temperature;   //[C/16]
+    int16_t setpoint;      //[C/16]
+    int16_t slope;         //[C/h]
+    uint16_t data;         //type specific
+}flashlog_record_t;
+
+/*
+ * storage backend, program never crosses a FLASHLOG_PAGE_SIZE boundary,
+ * erase is called with FLASHLOG_SECTOR_SIZE or FLASHLOG_BLOCK_SIZE aligned regions.
+ * program and erase may return before the device finished, is_busy reports that.
+ */
+typedef struct
+{
+    void* ctx;
+    uint32_t size; //bytes
+    HAL_StatusTypeDef (*read)(void* ctx, uint32_t addr, uint8_t* data, uint16_t len);
+    HAL_StatusTypeDef (*program)(void* ctx, uint32_t addr, const uint8_t* data, uint16_t len);
+    HAL_StatusTypeDef (*erase)(void* ctx, uint32_t addr, uint32_t len);
+    uint8_t (*is_busy)(void* ctx);
+}flashlog_device_t;
+
+//output function for flashlog_dump
+typedef void (*flashlog_write_fn_t)(const uint8_t* data, uint16_t len);
+
+typedef struct
+{
+    const flashlog_device_t* dev;
+
+    uint32_t index_addr;        //next free index entry
+    uint32_t index_seq;         //sequence number of next index entry
+    uint32_t index_erased_addr; //index sector known to be erased, 0xFFFFFFFF if none
+
+    uint32_t write_addr;        //next free data address
+    uint32_t block_erased_addr; //data block known to be erased, 0xFFFFFFFF if none
+    uint32_t mark_addr;         //data block whose MARK entry is written, 0xFFFFFFFF if none
+    uint32_t start_addr;        //data address of current / last firing
+    uint16_t firing_id;         //current / last firing
+    uint8_t firing_active;
+
+    flashlog_record_t queue[FLASHLOG_QUEUE_LENGTH];
+    volatile uint8_t queue_head; //written by flashlog_append
+    volatile uint8_t queue_tail; //written by flashlog_process
+    uint32_t dropped_count;      //records lost because the queue was full
+}Flashlog_HandleTypeDef_t;
+
+HAL_StatusTypeDef initFlashlog(Flashlog_HandleTypeDef_t* hlog, const flashlog_device_t* dev);
+HAL_StatusTypeDef flashlog_format(Flashlog_HandleTypeDef_t* hlog);
+HAL_StatusTypeDef flashlog_start_firing(Flashlog_HandleTypeDef_t* hlog);
+HAL_StatusTypeDef flashlog_end_firing(Flashlog_HandleTypeDef_t* hlog);
+HAL_StatusTypeDef flashlog_append(Flashlog_HandleTypeDef_t* hlog, flashlog_record_t* record);
+HAL_StatusTypeDef flashlog_process(Flashlog_HandleTypeDef_t* hlog);
+uint8_t flashlog_is_idle(Flashlog_HandleTypeDef_t* hlog);
+HAL_StatusTypeDef flashlog_dump(Flashlog_HandleTypeDef_t* hlog, flashlog_write_fn_t write);
+
+#ifdef FLASHLOG_HOST
+//file backed stand-in for host tests, see flashlog_file.c
+HAL_StatusTypeDef flashlog_file_open(flashlog_device_t* dev, const char* path, uint32_t size);
+void flashlog_file_close(flashlog_device_t* dev);
+#endif
+
+#endif /* INC_FLASHLOG_H_ */
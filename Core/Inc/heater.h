@@ -8,10 +8,15 @@
 #ifndef INC_HEATER_H_
 #define INC_HEATER_H_
 
-#define PWM_ON_SECONDS 2 //how long a coil stays on in PWM mode
+#define PWM_ON_SECONDS 2 //default of how long a coil stays on in PWM mode
+#define HEATER_MIN_CYCLE_SECONDS 1 //limits of heater_set_cycle_time
+#define HEATER_MAX_CYCLE_SECONDS 60
 #define INTERUPT_INTERVAL_SECONDS 1 //RTC intervall, needs to be lower than following two intervals
-#define TEMPERATURE_SAMPLING_INTERVAL_SECONDS 1 //sampling intervall for temperature measurement
-#define PID_CALC_INTERVAL_SECONDS 10 //intervall for calculation of new pid value
+#define TEMPERATURE_SAMPLING_INTERVAL_SECONDS 1 //default sampling intervall for temperature measurement
+#define PID_CALC_INTERVAL_SECONDS 10 //default intervall for calculation of new pid value
+#define LOG_INTERVAL_SECONDS 1 //default intervall for temperature log output
+#define HEATER_MAX_LEVEL 6 //highest heater level, all coils on
+#define HEATER_PHASES 3 //supply phases the coils can be wired to
 
 #include <stdio.h>
 #include "main.h"
@@ -20,10 +25,9 @@
 #include "arm_math.h"
 #include "log.h"
 #include "MAX31855.h"
-
-//enable printf logs for this file
-#define HEATER_ENABLE_LOG
-
+#include "pid.h"
+#include "scheduler.h"
+#include "sim.h"
 
 //max length for temperature measurement arrays
 #define MAX_MEAS_AR_LENGTH 20
@@ -32,6 +36,13 @@
  * Usage:
  * create a Heater_HandleTypedef and pass it to the init function
  *
+ * optionally attach a pid controller and a scheduler with heater_init_control,
+ * the scheduler then adapts sampling, pid and log interval at the end of every pid window
+ *
+ * heater_set_setpoint enables closed loop control: at the end of every pid window the
+ * mean temperature is fed to the pid and its output plus the feed forward becomes the
+ * new heater level
+ *
  * set a level
  * set state will turn heater on to said level
  * set state needs to be called more frequent then PWM_ON_MSECONDS in order for pwm to update
@@ -40,6 +51,19 @@
  *
  * if door is open heater will set itself to level 0 and resume once flag is reset.
  * set_state needs to be called to update though
+ *
+ * heater_set_phases enables the balanced allocation for coils on different supply phases:
+ * instead of the fixed order of heater_set_level, every cycle time slot the demand of the
+ * level (in half coils) is handed out as whole coils to the phases with the least on time so far.
+ * The on time of all phases stays within a slot of each other, phase_imbalance reports the
+ * spread of the last pid window, it is part of the firing log samples. A new level takes
+ * effect with the next slot, slots are not cut short
+ *
+ * heater_set_cycle_time replaces PWM_ON_SECONDS as pwm on and off time and slot length.
+ * The new value waits for the next switching edge or slot, see cycletime.h for the optimiser
+ *
+ * heater_set_simulation attaches a kiln model, the coil outputs are masked off and the
+ * model replaces the thermocouple until it is detached again with NULL
  */
 
 /*
@@ -61,6 +85,8 @@ typedef struct
     uint16_t pin;
     heater_coil_state_t state;
     uint32_t time_pwm_last; //used to keep time in 50% PWM signal
+    uint16_t output_mask;   //pin if the output may be set, 0 while simulating
+    uint8_t phase;          //supply phase 0..HEATER_PHASES-1, used by balanced allocation
 
 }heater_coil_t;
 
@@ -84,9 +110,42 @@ typedef struct
 
     heater_coils_t coils;      //struct for coil states etc
 
-    float32_t temperature[PID_CALC_INTERVAL_SECONDS / INTERUPT_INTERVAL_SECONDS]; //stores temparuter data
+    float32_t temperature[MAX_MEAS_AR_LENGTH]; //stores temparuter data
     MAX31855_HandleTypeDef_t* htemp;
     uint8_t time_counter;
+    uint8_t sample_count;      //samples stored in temperature array
+
+    uint8_t sampling_interval; //current sampling interval [s]
+    uint8_t pid_interval;      //current pid interval [s]
+    uint8_t log_interval;      //current log interval [s]
+    uint16_t log_counter;
+    float32_t slope_denominator; //least squares denominator for current interval
+
+    PID_HandletypeDef_t* hpid;           //optional, NULL if not attached
+    Scheduler_HandleTypeDef_t* hsched;   //optional, NULL if not attached
+    Sim_HandleTypeDef_t* hsim;           //optional, kiln model replacing coils and thermocouple
+
+    uint8_t control_enabled;     //pid sets heater level at end of pid window
+    uint8_t pid_level;           //level demanded by the pid
+    int8_t demand_offset;        //added to pid_level, used for excitation
+    float32_t feedforward;       //[levels] added to the pid output, set by the firing
+    float32_t setpoint;          //[C] reference for pid
+    float32_t last_temperature;  //[C] last sampled temperature
+    float32_t slope;             //[C/h] slope of last pid window
+    float32_t mean;              //[C] mean of last pid window
+    uint8_t window_interval;     //[s] pid interval of last pid window, pid_interval may already be the next one
+    uint16_t window_count;       //pid windows finished, slope and mean are new when it changes
+
+    uint8_t balanced;            //coils allocated by phase on time instead of fixed order
+    uint8_t slot_remaining;      //[s] until the next allocation
+    uint8_t credit;              //[half coils] demand not allocated yet
+    uint8_t rotation;            //coil tried first on equal phase on time
+    uint32_t phase_on[HEATER_PHASES];   //[s] on time per phase, relative to the least
+    uint16_t window_on[HEATER_PHASES];  //[s] on time per phase in current pid window
+    uint8_t phase_imbalance;     //[% of pid window] max - min phase on time of last window
+
+    uint8_t cycle_time;          //[s] pwm on and off time, slot length of balanced allocation
+    uint8_t cycle_pending;       //[s] cycle time from the next switching edge on
 }Heater_HandleTypeDef_t;
 
 
@@ -96,6 +155,19 @@ HAL_StatusTypeDef initHeater(Heater_HandleTypeDef_t* hheater,MAX31855_HandleType
 HAL_StatusTypeDef heater_set_level(Heater_HandleTypeDef_t* hheater, uint8_t level);
 HAL_StatusTypeDef heater_set_state(Heater_HandleTypeDef_t* hheater);
 HAL_StatusTypeDef heater_turn_off(Heater_HandleTypeDef_t* hheater);
+HAL_StatusTypeDef heater_init_control(Heater_HandleTypeDef_t* hheater, PID_HandletypeDef_t* hpid, Scheduler_HandleTypeDef_t* hsched);
+HAL_StatusTypeDef heater_set_setpoint(Heater_HandleTypeDef_t* hheater, float32_t setpoint);
+HAL_StatusTypeDef heater_disable_control(Heater_HandleTypeDef_t* hheater);
+HAL_StatusTypeDef heater_set_demand_offset(Heater_HandleTypeDef_t* hheater, int8_t offset);
+HAL_StatusTypeDef heater_set_feedforward(Heater_HandleTypeDef_t* hheater, float32_t feedforward);
+HAL_StatusTypeDef heater_set_intervals(Heater_HandleTypeDef_t* hheater, uint8_t sampling_interval, uint8_t pid_interval, uint8_t log_interval);
+HAL_StatusTypeDef heater_set_phases(Heater_HandleTypeDef_t* hheater, uint8_t coil1_phase, uint8_t coil2_phase, uint8_t coil3_phase);
+HAL_StatusTypeDef heater_set_simulation(Heater_HandleTypeDef_t* hheater, Sim_HandleTypeDef_t* hsim);
+HAL_StatusTypeDef heater_set_cycle_time(Heater_HandleTypeDef_t* hheater, uint8_t cycle_time);
+uint8_t heater_get_outputs(Heater_HandleTypeDef_t* hheater);
+uint8_t heater_count_switches(uint8_t previous, uint8_t outputs);
+float32_t heater_calculate_slope(Heater_HandleTypeDef_t* hheater);
+float32_t heater_calculate_mean(Heater_HandleTypeDef_t* hheater);
 void heater_on_interupt(Heater_HandleTypeDef_t* hheater,RTC_HandleTypeDef *hrtc);
 
 #endif /* INC_HEATER_H_ */
@@ -0,0 +1,48 @@
+/*
+ * heatwork.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_HEATWORK_H_
+#define INC_HEATWORK_H_
+
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+
+/*
+ * Heat work integrator, cone equivalent of a firing.
+ *
+ * Maturing follows an Arrhenius law, one second at T counts as exp(E/R * (1/T0 - 1/T))
+ * seconds at T0 = 850C with E/R = 75000K (doubles about every 20C at cone 6).
+ * The rate is a flash table every HEATWORK_TABLE_STEP C, interpolated linearly and
+ * summed as integer. Below 850C nothing counts.
+ * A cone is reached with the heat work of a 60C/h ramp to its Orton temperature at
+ * that rate, these targets are a second table computed with the same integer rates.
+ *
+ * Cones are numbered 1..HEATWORK_CONES from 010 to 10, 0 is no cone.
+ *
+ * Usage:
+ * heatwork_reset at firing start, then heatwork_add with every temperature sample.
+ * cone holds the highest cone reached, heatwork_get_progress the percentage of a cone.
+ */
+
+#define HEATWORK_TABLE_START 850    //[C] first entry of rate table
+#define HEATWORK_TABLE_STEP 10      //[C] between entries
+#define HEATWORK_TABLE_LENGTH 51    //up to 1350C, rate stays at last entry above
+#define HEATWORK_CONES 20
+
+typedef struct
+{
+    uint64_t work;    //[rate units * s] since reset
+    uint8_t cone;     //highest cone reached, 0 none
+}Heatwork_HandleTypeDef_t;
+
+void heatwork_reset(Heatwork_HandleTypeDef_t* hwork);
+void heatwork_add(Heatwork_HandleTypeDef_t* hwork, float32_t temperature, uint8_t seconds);
+uint8_t heatwork_is_reached(const Heatwork_HandleTypeDef_t* hwork, uint8_t cone);
+uint16_t heatwork_get_progress(const Heatwork_HandleTypeDef_t* hwork, uint8_t cone);
+const char* heatwork_cone_name(uint8_t cone);
+
+#endif /* INC_HEATWORK_H_ */
@@ -0,0 +1,85 @@
+/*
+ * loadest.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_LOADEST_H_
+#define INC_LOADEST_H_
+
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+#include "heater.h"
+
+/*
+ * Load mass estimation at the start of a firing.
+ *
+ * Usage:
+ * loadest_start runs the heater open loop at LOADEST_LEVEL. loadest_on_interupt needs
+ * to be called every RTC interrupt before heater_on_interupt and returns 1 once the
+ * estimate is done. After LOADEST_SETTLE_SECONDS for the elements to heat through, the
+ * slopes of all pid windows within LOADEST_MEASURE_SECONDS are averaged.
+ * Close to ambient the losses are small, so the slope is roughly power / heat capacity.
+ * Compared to the slope of a nominal load this gives a load factor:
+ *      factor = LOADEST_NOMINAL_SLOPE / slope
+ * 1 is a nominal (half full) kiln, 2 a kiln with twice its heat capacity.
+ * The pid gains are tuned for the nominal load and scale with the factor,
+ * the feed forward gain [levels per C/h] follows from the measured slope per level.
+ */
+
+//heater level during the measurement
+#define LOADEST_LEVEL 3
+#define LOADEST_SETTLE_SECONDS 300
+#define LOADEST_MEASURE_SECONDS 600
+//[C/h] slope of a nominal load at LOADEST_LEVEL
+#define LOADEST_NOMINAL_SLOPE 150.0f
+//limits of the load factor
+#define LOADEST_MIN_FACTOR 0.5f
+#define LOADEST_MAX_FACTOR 2.5f
+//class boundaries of the load factor
+#define LOADEST_LIGHT_FACTOR 0.75f
+#define LOADEST_HEAVY_FACTOR 1.5f
+//[C] first segment has to heat at least this much, else there is nothing to measure
+#define LOADEST_MIN_RISE 50.0f
+
+typedef enum
+{
+    LOADEST_IDLE = 0,
+    LOADEST_SETTLE = 1,
+    LOADEST_MEASURE = 2,
+    LOADEST_DONE = 3
+}loadest_state_t;
+
+typedef enum
+{
+    LOADEST_CLASS_NOMINAL = 0,   //also used if no estimate was made
+    LOADEST_CLASS_LIGHT = 1,
+    LOADEST_CLASS_HEAVY = 2
+}loadest_class_t;
+
+typedef struct
+{
+    loadest_state_t state;
+    uint16_t time;           //[s] since start
+    uint16_t last_window;    //heater window count of last used slope
+    uint8_t skip_window;     //next window started before the measurement
+    float32_t slope_sum;     //[C/h]
+    uint8_t slope_count;
+    float32_t start_temperature; //[C] at start of measurement
+
+    float32_t slope;         //[C/h] result at LOADEST_LEVEL
+    float32_t factor;        //heat capacity relative to nominal load
+    loadest_class_t load_class;
+
+    Heater_HandleTypeDef_t* hheater;
+}Loadest_HandleTypeDef_t;
+
+HAL_StatusTypeDef initLoadest(Loadest_HandleTypeDef_t* hload, Heater_HandleTypeDef_t* hheater);
+HAL_StatusTypeDef loadest_start(Loadest_HandleTypeDef_t* hload);
+void loadest_stop(Loadest_HandleTypeDef_t* hload);
+uint8_t loadest_is_running(Loadest_HandleTypeDef_t* hload);
+float32_t loadest_get_feedforward_gain(Loadest_HandleTypeDef_t* hload);
+uint8_t loadest_on_interupt(Loadest_HandleTypeDef_t* hload);
+
+#endif /* INC_LOADEST_H_ */
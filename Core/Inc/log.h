@@ -10,6 +10,11 @@
  *      outputs it to uart(handle gets passed in initLog)
  *      also reroutes printf if REROUTE_PRINTF is defined
  *
+ *      every module logs to its own channel: define LOG_CHANNEL in the .c file
+ *      after the includes and use LOG_MSG(level, ...). Each channel has a mask of
+ *      enabled levels that can be changed at runtime (console: log <channel> <level>).
+ *      A call on a disabled channel costs one load and branch, calls below
+ *      LOG_COMPILE_LEVEL are removed by the compiler.
  *
  *      TBD: logging feature to file
  */
@@ -19,14 +24,61 @@
 
 
 #include "stm32f0xx_hal.h"
+#include "dmamgr.h"
 
 #define LOG_DEBUG   0
 #define LOG_INFO    1
 #define LOG_WARNING 2
 #define LOG_ERROR   3
 
-//adjusts which messages get deisplayed
-#define LOG_LEVEL_THRESHOLD 0
+//used to turn a channel off
+#define LOG_OFF     4
+
+//calls below this level generate no code
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+
+//default runtime mask of all channels, info and up
+#define LOG_DEFAULT_LEVEL LOG_INFO
+
+//log channels, one per module
+typedef enum
+{
+    LOG_CH_MAIN,
+    LOG_CH_HEATER,
+    LOG_CH_UI,
+    LOG_CH_EVENT,
+    LOG_CH_FIRING,
+    LOG_CH_SYSID,
+    LOG_CH_FLASHLOG,
+    LOG_CH_SHADOW,
+    LOG_CH_COUNT
+}log_channel_t;
+
+//mask bit of a level and mask of a level and all above
+#define LOG_MASK(level) (1U << (level))
+#define LOG_MASK_FROM(level) ((0x0FU << (level)) & 0x0FU)
+
+//enabled levels per channel, written by log_set_mask
+extern uint8_t log_channel_mask[LOG_CH_COUNT];
+
+#define LOG_ENABLED(channel, level) \
+    ((level) >= LOG_COMPILE_LEVEL && (log_channel_mask[(channel)] & LOG_MASK(level)))
+
+#define LOG_CH_MSG(channel, level, ...) \
+    do { if (LOG_ENABLED(channel, level)) { logMsg((level), __VA_ARGS__); } } while (0)
+
+//logs to the channel of the calling module
+#define LOG_MSG(level, ...) LOG_CH_MSG(LOG_CHANNEL, level, __VA_ARGS__)
+
+//baudrate for bulk transfers like the firing log dump, HSI 8MHz keeps the error below 1%
+#define LOG_BAUDRATE_DEFAULT 9600
+#define LOG_BAUDRATE_FAST 230400
+//logWrite with dma attached: bytes are copied into alternating buffers so the caller
+//can prepare the next chunk while the last one is sent
+#define LOG_DMA_BUFFERS 2
+#define LOG_DMA_BUFFER_SIZE 32
 
 
 
@@ -34,6 +86,11 @@
 #define REROUTE_PRINTF
 void initLog(UART_HandleTypeDef* huart);
 void logMsg(int logLevel, const char* format, ...);
+HAL_StatusTypeDef log_set_mask(const char* channel, uint8_t mask);
+void log_print_masks(void);
+void log_attach_dma(Dmamgr_HandleTypeDef_t* hdma, dmamgr_request_t request);
+void logWrite(const uint8_t* data, uint16_t len);
+HAL_StatusTypeDef logSetBaudRate(uint32_t baudrate);
 
 //Rerourung printf stuff
 #ifdef REROUTE_PRINTF
@@ -46,6 +46,21 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
+/*
+ * places a function in the .RamFunc section. The section is linked into .data,
+ * so the startup code copies it from flash to RAM together with initialized data.
+ * Only for code that calls little in flash, a RAM function calling flash waits for it anyway.
+ * The linker script adds the soft float add, sub, mul and arm_mean_f32 to the section, so the
+ * slope and mean filters and PID_Calculate qualify; division and compare stay in flash.
+ * Used for these, the coil outputs and the payload decode. "bench" measures the gain.
+ */
+#define RAMFUNC __attribute__((section(".RamFunc"), noinline))
+
+/*
+ * places a variable in the .noinit section. The startup code neither zeroes nor copies it,
+ * the content survives a reset but is random after power up.
+ */
+#define NOINIT __attribute__((section(".noinit")))
 
 /* USER CODE END EM */
 
@@ -53,6 +68,14 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+HAL_StatusTypeDef firing_log_dump(void);
+void blackbox_log_dump(void);
+HAL_StatusTypeDef simulation_set(uint8_t acceleration);
+HAL_StatusTypeDef shadow_set(uint8_t enable, float k_p, float k_i, float k_d);
+void shadow_log_stats(void);
+void dma_log_stats(void);
+void cycle_log_stats(void);
+void ramfunc_benchmark(void);
 
 /* USER CODE END EFP */
 
@@ -90,6 +113,9 @@ void Error_Handler(void);
 #define ENC_A_GPIO_Port GPIOB
 
 /* USER CODE BEGIN Private defines */
+//chip select of the log flash, shares SPI2 with the MAX31855
+#define FLASH_NSS_Pin GPIO_PIN_11
+#define FLASH_NSS_GPIO_Port GPIOB
 
 /* USER CODE END Private defines */
 
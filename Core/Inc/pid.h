@@ -33,6 +33,27 @@ typedef struct
     float32_t derivative_filter_coeff; //low pass filter coef
     float32_t hysteresis; // Define temperature thresholds and hysteresis
 
+    float32_t sample_time; // time between two calculations [s]
+    float32_t k_integral_discrete; // k_integral * sample_time
+    float32_t k_derivative_discrete; // k_derivative / sample_time
+
+    float32_t output_min; // output limits of PID_Calculate
+    float32_t output_max;
+
+    float32_t integral; // controller state
+    float32_t last_error;
+    float32_t last_derivative;
+    float32_t last_measurement;
+
 }PID_HandletypeDef_t;
 
+void PID_Init(PID_HandletypeDef_t *hpid, float32_t k_p, float32_t k_i, float32_t k_d,
+            float32_t hysteresis, float32_t k_d_filter_coeff);
+void PID_UpdateParameters(PID_HandletypeDef_t *hpid, float32_t k_p, float32_t k_i, float32_t k_d, float32_t hysteresis);
+void PID_SetSampleTime(PID_HandletypeDef_t *hpid, float32_t sample_time);
+void PID_SetOutputLimits(PID_HandletypeDef_t *hpid, float32_t output_min, float32_t output_max);
+void PID_Reset(PID_HandletypeDef_t *hpid, float32_t current_temperature);
+float32_t PID_Calculate(PID_HandletypeDef_t *hpid, float32_t current_temperature, float32_t setpoint);
+PID_Controller_Output_t PID_CalculateOutput(PID_HandletypeDef_t *hpid, float32_t current_temperature, float32_t setpoint);
+
 #endif /* INC_PID_H_ */
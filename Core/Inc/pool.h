@@ -0,0 +1,66 @@
+/*
+ * pool.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_POOL_H_
+#define INC_POOL_H_
+
+#include "stm32f0xx_hal.h"
+
+/*
+ * Fixed block pool allocator, replaces malloc in the firmware.
+ *
+ * Every pool is a static array of equal blocks sized at compile time with POOL_MEMORY.
+ * Free blocks form a singly linked list through their first word, so pool_alloc and
+ * pool_free are O(1). Both run with interrupts disabled and can be called from ISRs.
+ * A pool counts blocks in use, the high water mark and failed allocations, pool_print_stats
+ * prints all initialized pools and how much of the heap reservation (_Min_Heap_Size) newlib
+ * has taken so far, the float formatting of printf still allocates from it.
+ *
+ * With POOL_DEBUG defined freed blocks are filled with POOL_POISON, pool_alloc checks the
+ * poison is intact (write after free) and pool_free rejects pointers not of the pool.
+ *
+ * Usage:
+ *  POOL_MEMORY(my_memory, sizeof(my_t), 8);
+ *  initPool(&hpool, "my", my_memory, sizeof(my_t), 8);
+ *  my_t* p = pool_alloc(&hpool); ... pool_free(&hpool, p);
+ */
+
+//#define POOL_DEBUG
+#define POOL_POISON 0xA5
+#define POOL_MAX_POOLS 4
+
+//block size rounded up to whole words, at least one for the free list
+#define POOL_BLOCK_WORDS(block_size) (((block_size) + 3U) / 4U)
+//static storage of a pool, word aligned
+#define POOL_MEMORY(name, block_size, blocks) static uint32_t name[POOL_BLOCK_WORDS(block_size) * (blocks)]
+
+typedef struct pool_block_t
+{
+    struct pool_block_t* next;
+}pool_block_t;
+
+typedef struct
+{
+    const char* name;
+    uint8_t* memory;
+    uint16_t block_size;    //[bytes] rounded up to words
+    uint16_t blocks;
+    pool_block_t* free;     //first free block, NULL if exhausted
+    uint16_t used;          //blocks in use
+    uint16_t high_water;    //max blocks in use
+    uint16_t failures;      //allocations that found the pool empty
+#ifdef POOL_DEBUG
+    uint16_t corruptions;   //poison overwritten or foreign pointer freed
+#endif
+}Pool_HandleTypeDef_t;
+
+HAL_StatusTypeDef initPool(Pool_HandleTypeDef_t* hpool, const char* name, uint32_t* memory, uint16_t block_size, uint16_t blocks);
+void* pool_alloc(Pool_HandleTypeDef_t* hpool);
+void pool_free(Pool_HandleTypeDef_t* hpool, void* block);
+void pool_print_stats(void);
+
+#endif /* INC_POOL_H_ */
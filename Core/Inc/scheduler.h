@@ -0,0 +1,101 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_SCHEDULER_H_
+#define INC_SCHEDULER_H_
+
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+
+/*
+ * Usage:
+ * the heater calls scheduler_update() at the end of every pid window with the
+ * measured slope and mean temperature. The scheduler picks one of the rate sets
+ * below depending on how far the kiln is from its target and returns 1 if the
+ * rates changed, the heater then recomputes filter and controller coefficients.
+ *
+ * scheduler_set_target() is called by whoever owns the setpoint, a changed target
+ * counts as a segment transition and forces the fast rate.
+ */
+
+//temperature band around the target in which the approach is sampled fast [C]
+#define SCHEDULER_APPROACH_BAND 30.0f
+//temperature band around the target in which a hold counts as settled [C]
+#define SCHEDULER_SETTLED_BAND 5.0f
+//slope error above which the loop runs fast [C/h]
+#define SCHEDULER_SLOPE_ERROR_FAST 60.0f
+//slope error below which the loop may slow down [C/h]
+#define SCHEDULER_SLOPE_ERROR_SLOW 15.0f
+//consecutive calm windows needed before stepping down one rate
+#define SCHEDULER_CALM_WINDOWS 3
+
+/*
+ * rate sets, intervals in seconds. pid / sampling must not exceed MAX_MEAS_AR_LENGTH
+ */
+#define SCHEDULER_FAST_SAMPLING 1
+#define SCHEDULER_FAST_PID 5
+#define SCHEDULER_FAST_LOG 5
+
+#define SCHEDULER_NORMAL_SAMPLING 1
+#define SCHEDULER_NORMAL_PID 10
+#define SCHEDULER_NORMAL_LOG 10
+
+#define SCHEDULER_SLOW_SAMPLING 3
+#define SCHEDULER_SLOW_PID 30
+#define SCHEDULER_SLOW_LOG 60
+
+/*
+ * rate sets ordered from fast to slow
+ */
+typedef enum
+{
+    SCHEDULER_RATE_FAST = 0,
+    SCHEDULER_RATE_NORMAL = 1,
+    SCHEDULER_RATE_SLOW = 2
+}scheduler_rate_t;
+
+/*
+ * phase of the current segment, derived from target and measurement
+ */
+typedef enum
+{
+    SCHEDULER_PHASE_IDLE = 0, //no target set
+    SCHEDULER_PHASE_RAMP,     //heating towards target
+    SCHEDULER_PHASE_COOL,     //cooling towards target
+    SCHEDULER_PHASE_APPROACH, //close to the target
+    SCHEDULER_PHASE_HOLD      //settled at target
+}scheduler_phase_t;
+
+/*
+ * intervals of one rate set in seconds
+ */
+typedef struct
+{
+    uint8_t sampling_interval;
+    uint8_t pid_interval;
+    uint8_t log_interval;
+}scheduler_rates_t;
+
+typedef struct
+{
+    scheduler_rate_t rate;
+    scheduler_phase_t phase;
+
+    uint8_t target_valid;       //target has been set
+    uint8_t transition;         //target changed since last update
+    uint8_t calm_count;         //consecutive calm windows
+    float32_t target_temperature; //[C]
+    float32_t target_gradient;    //[C/h], 0 for hold
+}Scheduler_HandleTypeDef_t;
+
+HAL_StatusTypeDef initScheduler(Scheduler_HandleTypeDef_t* hsched);
+void scheduler_set_target(Scheduler_HandleTypeDef_t* hsched, float32_t temperature, float32_t gradient);
+void scheduler_clear_target(Scheduler_HandleTypeDef_t* hsched);
+uint8_t scheduler_update(Scheduler_HandleTypeDef_t* hsched, float32_t slope, float32_t mean);
+scheduler_rates_t scheduler_get_rates(Scheduler_HandleTypeDef_t* hsched);
+
+#endif /* INC_SCHEDULER_H_ */
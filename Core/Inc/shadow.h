@@ -0,0 +1,70 @@
+/*
+ * shadow.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_SHADOW_H_
+#define INC_SHADOW_H_
+
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+#include "heater.h"
+#include "pid.h"
+
+/*
+ * Shadow controller, qualifies candidate gains on real firings without risk.
+ *
+ * A second pid runs with the candidate gains on the same window sample as the live pid
+ * (mean, setpoint and feed forward of the heater), its level is only logged, never applied.
+ * It is reset whenever closed loop control starts and follows the pid interval of the heater.
+ *
+ * Every window logs on channel shadow:
+ *      SHADOW,<window>,<live level>,<shadow level>,<shadow output>,<cycles>
+ * and updates the divergence statistics. The cost of the shadow calculation is measured
+ * with SHADOW_TIMER running free on the core clock, a shadow that needs more than
+ * SHADOW_MAX_CYCLES is stopped. SysTick can not be used: the shadow runs in the RTC
+ * interrupt, which blocks the SysTick interrupt, so HAL_GetTick does not count reloads.
+ *
+ * Usage:
+ * shadow_on_interupt needs to be called every RTC interrupt after heater_on_interupt.
+ * shadow_start with candidate gains, shadow_stop, shadow_print_stats.
+ * shadow_timer_start and shadow_cycles_since time other code with the same timer.
+ */
+
+//cycle budget of the shadow calculation, 1% of a tick
+#define SHADOW_MAX_CYCLES (SystemCoreClock / 100U * INTERUPT_INTERVAL_SECONDS)
+//free running 16 bit timer for the measurement, one count every SHADOW_TIMER_PRESCALER cycles,
+//wraps after 524288 cycles, far above the budget
+#define SHADOW_TIMER TIM14
+#define SHADOW_TIMER_PRESCALER 8U
+
+typedef struct
+{
+    uint8_t running;
+    PID_HandletypeDef_t pid;     //candidate controller
+    uint8_t last_control;        //heater control enabled at last interrupt
+    uint16_t last_window;
+    uint8_t level;               //last shadow level
+
+    uint32_t windows;            //compared pid windows
+    uint32_t agree;              //windows with the same level
+    int32_t sum_diff;            //[levels] sum of shadow - live
+    uint32_t sum_abs;            //[levels] sum of |shadow - live|
+    uint8_t max_abs;             //[levels]
+    uint32_t cycles;             //last shadow calculation
+    uint32_t cycles_max;
+
+    Heater_HandleTypeDef_t* hheater;
+}Shadow_HandleTypeDef_t;
+
+HAL_StatusTypeDef initShadow(Shadow_HandleTypeDef_t* hshadow, Heater_HandleTypeDef_t* hheater);
+HAL_StatusTypeDef shadow_start(Shadow_HandleTypeDef_t* hshadow, float32_t k_p, float32_t k_i, float32_t k_d);
+void shadow_stop(Shadow_HandleTypeDef_t* hshadow);
+void shadow_on_interupt(Shadow_HandleTypeDef_t* hshadow);
+void shadow_print_stats(Shadow_HandleTypeDef_t* hshadow);
+uint16_t shadow_timer_start(void);
+uint32_t shadow_cycles_since(uint16_t start);
+
+#endif /* INC_SHADOW_H_ */
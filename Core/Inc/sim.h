@@ -0,0 +1,49 @@
+/*
+ * sim.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_SIM_H_
+#define INC_SIM_H_
+
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+
+/*
+ * Fixed point kiln model for dry runs on the bench.
+ *
+ * Two first order stages, temperatures in Q16 [C/65536]:
+ *  chamber: heated with SIM_GAIN_PER_LEVEL per heater level, loses heat to ambient with SIM_LOSS_TAU
+ *  sensor:  follows the chamber with SIM_SENSOR_TAU, lag of thermocouple and ware
+ * At level 6 the chamber settles at about 1300C and heats up with about 430C/h from cold.
+ *
+ * Usage:
+ * initSim, then sim_start with an acceleration and the start temperature.
+ * Attach it to the heater with heater_set_simulation, the heater then inhibits the coil outputs,
+ * steps the model with its level every tick and samples sim_get_temperature instead of the thermocouple.
+ * The caller runs the control tick acceleration times per RTC interrupt, outside of the
+ * interrupt so the main loop is not starved. Dry runs are kept out of the firing log
+ * and the black box.
+ */
+
+#define SIM_AMBIENT 20                //[C]
+#define SIM_GAIN_PER_LEVEL 1311       //[C/65536 per s] heating rate of one level without losses
+#define SIM_LOSS_TAU 10800            //[s] chamber to ambient time constant
+#define SIM_SENSOR_TAU 60             //[s] sensor to chamber time constant
+#define SIM_MAX_ACCELERATION 120      //control ticks per second
+
+typedef struct
+{
+    uint8_t acceleration;   //simulated seconds per second
+    int32_t chamber;        //[C/65536]
+    int32_t sensor;         //[C/65536]
+}Sim_HandleTypeDef_t;
+
+HAL_StatusTypeDef initSim(Sim_HandleTypeDef_t* hsim);
+HAL_StatusTypeDef sim_start(Sim_HandleTypeDef_t* hsim, uint8_t acceleration, float32_t temperature);
+void sim_step(Sim_HandleTypeDef_t* hsim, uint8_t level);
+float32_t sim_get_temperature(Sim_HandleTypeDef_t* hsim);
+
+#endif /* INC_SIM_H_ */
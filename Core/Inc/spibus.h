@@ -0,0 +1,41 @@
+/*
+ * spibus.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_SPIBUS_H_
+#define INC_SPIBUS_H_
+
+#include "stm32f0xx_hal.h"
+
+/*
+ * Arbiter for devices sharing one SPI bus (MAX31855 and external flash on SPI2).
+ *
+ * Usage:
+ * a driver calls spibus_acquire before pulling its chip select and spibus_release
+ * after releasing it. Acquire never blocks: if another device owns the bus it
+ * returns HAL_BUSY. The thermocouple is read from the RTC interrupt and skips a
+ * sample in that case, the flash is only accessed from the main loop.
+ */
+
+typedef enum
+{
+    SPIBUS_DEVICE_NONE = 0,
+    SPIBUS_DEVICE_MAX31855 = 1,
+    SPIBUS_DEVICE_FLASH = 2
+}spibus_device_t;
+
+typedef struct
+{
+    SPI_HandleTypeDef* hspi;
+    volatile spibus_device_t owner;
+    uint32_t contention_count; //acquire attempts that found the bus busy
+}Spibus_HandleTypeDef_t;
+
+HAL_StatusTypeDef initSpibus(Spibus_HandleTypeDef_t* hbus, SPI_HandleTypeDef* hspi);
+HAL_StatusTypeDef spibus_acquire(Spibus_HandleTypeDef_t* hbus, spibus_device_t device);
+void spibus_release(Spibus_HandleTypeDef_t* hbus, spibus_device_t device);
+
+#endif /* INC_SPIBUS_H_ */
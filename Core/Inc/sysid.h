@@ -0,0 +1,64 @@
+/*
+ * sysid.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_SYSID_H_
+#define INC_SYSID_H_
+
+#include <stdio.h>
+#include "stm32f0xx_hal.h"
+#include "arm_math.h"
+#include "log.h"
+#include "heater.h"
+
+/*
+ * Frequency response measurement around an operating point.
+ *
+ * Usage:
+ * while the heater runs closed loop (e.g. setpoint hold) call sysid_start.
+ * sysid_on_interupt needs to be called every RTC interrupt before heater_on_interupt.
+ * For every period in the sweep a square wave of +-SYSID_AMPLITUDE heater levels is
+ * added to the pid demand. The first period settles, the following SYSID_PERIODS
+ * periods are correlated with a sine/cosine reference in fixed point, for both the
+ * temperature and the applied heater level. Their ratio is the plant response at
+ * that frequency, gain [C/level] and phase [deg] are logged as
+ *      SYSID,<operating point>,<period s>,<gain>,<phase>
+ * After the last period the perturbation is removed and the pid continues alone.
+ */
+
+//perturbation amplitude in heater levels
+#define SYSID_AMPLITUDE 1
+//measured periods per frequency, one extra period settles first
+#define SYSID_PERIODS 2
+//length of sine table, power of two
+#define SYSID_SINE_LENGTH 64
+//fixed point scaling of temperature and level samples (Q4)
+#define SYSID_SAMPLE_SHIFT 4
+
+typedef struct
+{
+    uint8_t running;
+    uint8_t freq_index;     //index into sweep periods
+    uint32_t time;          //[s] since start of current frequency
+    int8_t offset;          //current perturbation in levels
+    float32_t operating_point; //[C] setpoint when measurement started
+
+    //correlation accumulators, Q4 * Q15
+    int64_t y_re;
+    int64_t y_im;
+    int64_t u_re;
+    int64_t u_im;
+
+    Heater_HandleTypeDef_t* hheater;
+}Sysid_HandleTypeDef_t;
+
+HAL_StatusTypeDef initSysid(Sysid_HandleTypeDef_t* hsysid, Heater_HandleTypeDef_t* hheater);
+HAL_StatusTypeDef sysid_start(Sysid_HandleTypeDef_t* hsysid);
+HAL_StatusTypeDef sysid_stop(Sysid_HandleTypeDef_t* hsysid);
+uint8_t sysid_is_running(Sysid_HandleTypeDef_t* hsysid);
+void sysid_on_interupt(Sysid_HandleTypeDef_t* hsysid);
+
+#endif /* INC_SYSID_H_ */
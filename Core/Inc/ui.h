@@ -16,8 +16,8 @@
 #include "lcd1602_rgb.h"
 #include "arm_math.h"
 #include "event.h"
-
-#define UI_ENABLE_LOG
+#include "firing.h"
+#include "sysid.h"
 
 #define UI_LCD_CHAR_SIZE 17
 
@@ -30,6 +30,12 @@
 //defines max allowed setting value both in negative and positive direction
 #define MAX_SETTING 20
 
+//defines max allowed hold time of a segment [min]
+#define MAX_HOLD 999
+
+//default target of setpoint hold mode
+#define SETPOINT_DEFAULT_TEMPERATURE 100
+
 //defines steps per event for buttons and encoder in input operations
 #define BUTTON_INC 5
 #define ENC_INC 20
@@ -56,9 +62,22 @@ typedef enum
    PROGRAMS_OVERVIEW,
    PROGRAM_DETAILED,
    CREATE_PROGRAM,
-   CREATE_PROGRAM_DETAILED
+   CREATE_PROGRAM_DETAILED,
+   SETPOINT_DETAILED,
+   PROGRAM_RUNNING
 }ui_menupoint_t;
 
+//segment value edited in the running program view
+typedef enum
+{
+   RUN_FIELD_NONE,
+   RUN_FIELD_GRADIENT,
+   RUN_FIELD_TARGET,
+   RUN_FIELD_HOLD,
+   RUN_FIELD_CONE,
+   RUN_FIELD_COUNT
+}ui_run_field_t;
+
 //struct for programm
 typedef struct
 {
@@ -106,9 +125,20 @@ typedef struct
 
     LCD1602_RGB_HandleTypeDef_t *hlcd;
     Event_Queue_HandleTypeDef_t *queue;
+    Firing_HandleTypeDef_t *hfiring;
+    Sysid_HandleTypeDef_t *hsysid;
 
 }Ui_HandleTypeDef_t;
 
-void initUI(Ui_HandleTypeDef_t* ui, Event_Queue_HandleTypeDef_t *queue, LCD1602_RGB_HandleTypeDef_t *hlcd);
+//default controller settings, defined in ui.c
+extern ui_setting_t kp_gradient;
+extern ui_setting_t ki_gradient;
+extern ui_setting_t kd_gradient;
+extern ui_setting_t kp_setpoint;
+extern ui_setting_t ki_setpoint;
+extern ui_setting_t kd_setpoint;
+
+void initUI(Ui_HandleTypeDef_t* ui, Event_Queue_HandleTypeDef_t *queue, LCD1602_RGB_HandleTypeDef_t *hlcd,
+        Firing_HandleTypeDef_t *hfiring, Sysid_HandleTypeDef_t *hsysid);
 HAL_StatusTypeDef ui_update(Ui_HandleTypeDef_t *ui);
 #endif /* INC_UI_H_ */
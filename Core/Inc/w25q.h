@@ -0,0 +1,55 @@
+/*
+ * w25q.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#ifndef INC_W25Q_H_
+#define INC_W25Q_H_
+
+#include "stm32f0xx_hal.h"
+#include "main.h"
+#include "spibus.h"
+#include "flashlog.h"
+
+/*
+ * Driver for W25Qxx SPI NOR flash on the shared SPI2 bus, chip select FLASH_NSS.
+ *
+ * Usage:
+ * initW25q reads the JEDEC id and the capacity, w25q_get_device returns the
+ * device the flash log writes through. Program and erase only start the operation,
+ * w25q_is_busy polls the status register until the chip finished.
+ * Every command is one chip select cycle with the bus acquired, so the
+ * thermocouple can be read between any two of them.
+ */
+
+#define W25Q_TIMEOUT 100
+#define W25Q_MANUFACTURER_ID 0xEF
+
+#define W25Q_CMD_WRITE_ENABLE 0x06
+#define W25Q_CMD_READ_STATUS1 0x05
+#define W25Q_CMD_READ_DATA 0x03
+#define W25Q_CMD_PAGE_PROGRAM 0x02
+#define W25Q_CMD_SECTOR_ERASE 0x20 //4K
+#define W25Q_CMD_BLOCK_ERASE 0xD8  //64K
+#define W25Q_CMD_JEDEC_ID 0x9F
+
+#define W25Q_STATUS_BUSY 0x01
+
+typedef struct
+{
+    Spibus_HandleTypeDef_t* hbus;
+    uint32_t size;   //[bytes] from JEDEC id
+    uint8_t busy;    //program or erase started and not yet seen finished
+    flashlog_device_t dev;
+}W25Q_HandleTypeDef_t;
+
+HAL_StatusTypeDef initW25q(W25Q_HandleTypeDef_t* hflash, Spibus_HandleTypeDef_t* hbus);
+HAL_StatusTypeDef w25q_read(W25Q_HandleTypeDef_t* hflash, uint32_t addr, uint8_t* data, uint16_t len);
+HAL_StatusTypeDef w25q_program(W25Q_HandleTypeDef_t* hflash, uint32_t addr, const uint8_t* data, uint16_t len);
+HAL_StatusTypeDef w25q_erase(W25Q_HandleTypeDef_t* hflash, uint32_t addr, uint32_t len);
+uint8_t w25q_is_busy(W25Q_HandleTypeDef_t* hflash);
+const flashlog_device_t* w25q_get_device(W25Q_HandleTypeDef_t* hflash);
+
+#endif /* INC_W25Q_H_ */
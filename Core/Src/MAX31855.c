@@ -16,14 +16,23 @@
 HAL_StatusTypeDef max31855_init(MAX31855_HandleTypeDef_t* hmax31855, SPI_HandleTypeDef* hspi)
 {
     hmax31855->hspi = hspi;
+    hmax31855->hbus = NULL;
     HAL_GPIO_WritePin(SPI2_NSS_GPIO_Port, SPI2_NSS_Pin, GPIO_PIN_SET);
     return HAL_OK;
 }
 
+/*
+ * shares the spi bus with other devices through the arbiter
+ */
+void max31855_attach_bus(MAX31855_HandleTypeDef_t* hmax31855, Spibus_HandleTypeDef_t* hbus)
+{
+    hmax31855->hbus = hbus;
+}
+
 /*
  * updates payload struct fields with values just read
  */
-static HAL_StatusTypeDef max31855_update_payload(MAX31855_HandleTypeDef_t *hmax31855) {
+RAMFUNC static HAL_StatusTypeDef max31855_update_payload(MAX31855_HandleTypeDef_t *hmax31855) {
     if (NULL == hmax31855) {
         return HAL_ERROR;
     }
@@ -50,7 +59,8 @@ static HAL_StatusTypeDef max31855_update_payload(MAX31855_HandleTypeDef_t *hmax3
 
 
 /*
- * reads and updates data through SPi from MAX31855
+ * reads and updates data through SPi from MAX31855.
+ * HAL_BUSY if the shared bus is in use, payload keeps the last reading then
  */
 HAL_StatusTypeDef max31855_read_data(MAX31855_HandleTypeDef_t *hmax31855)
 {
@@ -63,15 +73,23 @@ HAL_StatusTypeDef max31855_read_data(MAX31855_HandleTypeDef_t *hmax31855)
         {
             return HAL_ERROR;
         }
+    if (NULL != hmax31855->hbus && HAL_OK != spibus_acquire(hmax31855->hbus, SPIBUS_DEVICE_MAX31855))
+        {
+            return HAL_BUSY;
+        }
     //TODO: non blocking implementation (DMA?)
     HAL_GPIO_WritePin(SPI2_NSS_GPIO_Port, SPI2_NSS_Pin, GPIO_PIN_RESET);
-    if (HAL_SPI_Receive(hmax31855->hspi, hmax31855->raw_payload,
-            MAX31855_PAYLOAD_LENGTH/8, MAX31855_TIMEOUT) != HAL_OK)
+    HAL_StatusTypeDef status = HAL_SPI_Receive(hmax31855->hspi, hmax31855->raw_payload,
+            MAX31855_PAYLOAD_LENGTH/8, MAX31855_TIMEOUT);
+    HAL_GPIO_WritePin(SPI2_NSS_GPIO_Port, SPI2_NSS_Pin, GPIO_PIN_SET);
+    if (NULL != hmax31855->hbus)
+        {
+            spibus_release(hmax31855->hbus, SPIBUS_DEVICE_MAX31855);
+        }
+    if (HAL_OK != status)
         {
-            HAL_GPIO_WritePin(SPI2_NSS_GPIO_Port, SPI2_NSS_Pin, GPIO_PIN_SET);
             return HAL_ERROR;
         }
-    HAL_GPIO_WritePin(SPI2_NSS_GPIO_Port, SPI2_NSS_Pin, GPIO_PIN_SET);
 
     return max31855_update_payload(hmax31855);
 
@@ -0,0 +1,217 @@
+/*
+ * blackbox.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "blackbox.h"
+#include <stdio.h>
+
+//not initialized by the startup code, survives resets
+NOINIT static blackbox_ring_t blackbox_ring;
+
+/*
+ * CRC32 of words with the hardware CRC unit. The unit is shared by the dump and the capture
+ * in the RTC interrupt, so a calculation runs with interrupts masked
+ */
+static uint32_t blackbox_crc(const uint32_t* words, uint8_t length, uint32_t last_mask)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    CRC->CR = CRC_CR_RESET;
+    for(uint8_t i = 0; i < length - 1; i++)
+    {
+        CRC->DR = words[i];
+    }
+    CRC->DR = words[length - 1] & last_mask;
+    uint32_t crc = CRC->DR;
+    if(!primask)
+    {
+        __enable_irq();
+    }
+    return crc;
+}
+
+static uint8_t blackbox_record_check(const blackbox_record_t* record)
+{
+    return (uint8_t)blackbox_crc((const uint32_t*)record, sizeof(blackbox_record_t) / 4, 0x00FFFFFFU);
+}
+
+static uint32_t blackbox_header_crc(const blackbox_ring_t* ring)
+{
+    return blackbox_crc((const uint32_t*)ring, 2, 0xFFFFFFFFU);
+}
+
+/*
+ * index of the i-th oldest record
+ */
+static uint16_t blackbox_index(const blackbox_ring_t* ring, uint16_t i)
+{
+    return (ring->head + BLACKBOX_LENGTH - ring->count + i) % BLACKBOX_LENGTH;
+}
+
+/*
+ * converts to Q4 fixed point, limited to int16
+ */
+static int16_t blackbox_q4(float32_t value)
+{
+    value *= 16;
+    if(32767.0f < value)
+    {
+        return 32767;
+    }
+    if(-32768.0f > value)
+    {
+        return -32768;
+    }
+    return (int16_t)value;
+}
+
+/*
+ * init function of recorder, keeps a valid ring from before the reset
+ */
+HAL_StatusTypeDef initBlackbox(Blackbox_HandleTypeDef_t* hbb, Heater_HandleTypeDef_t* hheater, Firing_HandleTypeDef_t* hfiring)
+{
+    if(NULL == hbb || NULL == hheater || NULL == hfiring)
+    {
+        return HAL_ERROR;
+    }
+    __HAL_RCC_CRC_CLK_ENABLE();
+    hbb->ring = &blackbox_ring;
+    hbb->hheater = hheater;
+    hbb->hfiring = hfiring;
+    hbb->time = 0;
+    hbb->last_window = hheater->window_count;
+    hbb->last_mode = hfiring->mode;
+    hbb->last_segment = 0;
+    hbb->last_fault = 0;
+    hbb->pending_event = BLACKBOX_EVENT_BOOT;
+
+    //reset flags, cleared for the next reset
+    hbb->reset_flags = (uint8_t)(RCC->CSR >> 24);
+    RCC->CSR |= RCC_CSR_RMVF;
+
+    blackbox_ring_t* ring = hbb->ring;
+    hbb->recovered = 0;
+    if(BLACKBOX_MAGIC == ring->magic && blackbox_header_crc(ring) == ring->crc
+            && BLACKBOX_LENGTH > ring->head && BLACKBOX_LENGTH >= ring->count)
+    {
+        for(uint16_t i = 0; i < ring->count; i++)
+        {
+            const blackbox_record_t* record = &ring->records[blackbox_index(ring, i)];
+            if(blackbox_record_check(record) == record->check)
+            {
+                hbb->recovered++;
+            }
+        }
+        return HAL_OK;
+    }
+    ring->magic = BLACKBOX_MAGIC;
+    ring->head = 0;
+    ring->count = 0;
+    ring->crc = blackbox_header_crc(ring);
+    return HAL_OK;
+}
+
+/*
+ * writes one record of the current control state
+ */
+static void blackbox_capture(Blackbox_HandleTypeDef_t* hbb)
+{
+    Heater_HandleTypeDef_t* hheater = hbb->hheater;
+    PID_HandletypeDef_t* hpid = hheater->hpid;
+    blackbox_ring_t* ring = hbb->ring;
+    blackbox_record_t* record = &ring->records[ring->head];
+
+    record->time = hbb->time;
+    record->temperature = blackbox_q4(hheater->mean);
+    record->setpoint = blackbox_q4(hheater->setpoint);
+    record->slope = blackbox_q4(hheater->slope / 16);
+    record->p_term = 0;
+    record->i_term = 0;
+    record->d_term = 0;
+    if(NULL != hpid)
+    {
+        record->p_term = blackbox_q4(hpid->k_proportional * hpid->last_error);
+        record->i_term = blackbox_q4(hpid->k_integral_discrete * hpid->integral);
+        record->d_term = blackbox_q4(hpid->k_derivative_discrete * hpid->last_derivative);
+    }
+    record->level = (BLACKBOX_EVENT_BOOT == hbb->pending_event) ? hbb->reset_flags : hheater->heater_level;
+    record->flags = (uint8_t)(hbb->last_segment << 4);
+    record->flags |= hheater->flag_door_open ? BLACKBOX_FLAG_DOOR_OPEN : 0;
+    record->flags |= hbb->last_fault ? BLACKBOX_FLAG_TC_FAULT : 0;
+    record->flags |= hheater->control_enabled ? BLACKBOX_FLAG_CONTROL : 0;
+    record->flags |= hbb->hfiring->estimating ? BLACKBOX_FLAG_ESTIMATING : 0;
+    record->event = hbb->pending_event;
+    record->check = blackbox_record_check(record);
+    hbb->pending_event = BLACKBOX_EVENT_NONE;
+
+    //header last, a reset in between leaves the old header valid
+    ring->head = (ring->head + 1) % BLACKBOX_LENGTH;
+    if(BLACKBOX_LENGTH > ring->count)
+    {
+        ring->count++;
+    }
+    ring->crc = blackbox_header_crc(ring);
+}
+
+/*
+ * tracks events and records at the end of every pid window, called every RTC interrupt
+ */
+void blackbox_on_interupt(Blackbox_HandleTypeDef_t* hbb)
+{
+    Firing_HandleTypeDef_t* hfiring = hbb->hfiring;
+    hbb->time += INTERUPT_INTERVAL_SECONDS;
+
+    //a dry run on the kiln model is not recorded, it would push out the real steps
+    if(NULL != hbb->hheater->hsim)
+    {
+        hbb->last_mode = hfiring->mode;
+        hbb->last_segment = hfiring->segment;
+        hbb->last_window = hbb->hheater->window_count;
+        return;
+    }
+
+    if(hfiring->mode != hbb->last_mode)
+    {
+        hbb->pending_event = (FIRING_IDLE == hfiring->mode) ? BLACKBOX_EVENT_FIRING_STOP : BLACKBOX_EVENT_FIRING_START;
+        hbb->last_mode = hfiring->mode;
+    }
+    else if(hfiring->segment != hbb->last_segment && FIRING_PROGRAM == hfiring->mode)
+    {
+        hbb->pending_event = BLACKBOX_EVENT_SEGMENT;
+    }
+    hbb->last_segment = hfiring->segment;
+
+    uint8_t fault = hbb->hheater->htemp->payload.fault;
+    if(fault && !hbb->last_fault)
+    {
+        hbb->pending_event = BLACKBOX_EVENT_TC_FAULT;
+    }
+    hbb->last_fault = fault;
+
+    if(hbb->last_window != hbb->hheater->window_count)
+    {
+        hbb->last_window = hbb->hheater->window_count;
+        blackbox_capture(hbb);
+    }
+}
+
+/*
+ * prints all records oldest first, records with a wrong check byte are marked
+ */
+void blackbox_dump(Blackbox_HandleTypeDef_t* hbb)
+{
+    blackbox_ring_t* ring = hbb->ring;
+    printf("BB: %u records, %u recovered, reset flags 0x%02x\r\n", ring->count, hbb->recovered, hbb->reset_flags);
+    for(uint16_t i = 0; i < ring->count; i++)
+    {
+        const blackbox_record_t* record = &ring->records[blackbox_index(ring, i)];
+        printf("BB%s,%lu,%d,%d,%d,%d,%d,%d,%u,0x%x,%u,%u\r\n",
+                (blackbox_record_check(record) == record->check) ? "" : "!",
+                (unsigned long)record->time, record->temperature, record->setpoint, record->slope * 16,
+                record->p_term, record->i_term, record->d_term, record->level,
+                record->flags & 0x0F, record->flags >> 4, record->event);
+    }
+}
@@ -0,0 +1,213 @@
+/*
+ * console.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "console.h"
+#include "main.h"
+#include "log.h"
+#include "sim.h"
+#include "pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_CHANNEL LOG_CH_MAIN
+
+//indexed by log level
+static const char* const console_level_names[] = {"debug", "info", "warning", "error", "off"};
+
+/*
+ * arms reception of the next byte. Clears errors first, a pending overrun from
+ * bytes that came in while reception was paused would abort it right away
+ */
+static void console_receive(Console_HandleTypeDef_t* hconsole)
+{
+    __HAL_UART_CLEAR_FLAG(hconsole->huart, UART_CLEAR_OREF | UART_CLEAR_FEF | UART_CLEAR_NEF);
+    HAL_UART_Receive_IT(hconsole->huart, &hconsole->rx_byte, 1);
+}
+
+/*
+ * init function of console, starts receiving
+ */
+HAL_StatusTypeDef initConsole(Console_HandleTypeDef_t* hconsole, UART_HandleTypeDef* huart)
+{
+    if(NULL == hconsole || NULL == huart)
+    {
+        return HAL_ERROR;
+    }
+    hconsole->huart = huart;
+    hconsole->length = 0;
+    hconsole->line_ready = 0;
+    console_receive(hconsole);
+    return HAL_OK;
+}
+
+/*
+ * collects received byte into the line, called from uart rx complete callback
+ */
+void console_on_receive(Console_HandleTypeDef_t* hconsole)
+{
+    char c = (char)hconsole->rx_byte;
+    if('\r' == c || '\n' == c)
+    {
+        if(0 != hconsole->length)
+        {
+            hconsole->line[hconsole->length] = '\0';
+            hconsole->line_ready = 1;
+            return;
+        }
+    }
+    else if(CONSOLE_LINE_LENGTH - 1 > hconsole->length)
+    {
+        hconsole->line[hconsole->length++] = c;
+    }
+    console_receive(hconsole);
+}
+
+/*
+ * restarts reception after an uart error, called from uart error callback.
+ * The partial line is dropped, a line waiting for the main loop is kept
+ */
+void console_on_error(Console_HandleTypeDef_t* hconsole)
+{
+    __HAL_UART_SEND_REQ(hconsole->huart, UART_RXDATA_FLUSH_REQUEST);
+    if(hconsole->line_ready)
+    {
+        return;
+    }
+    hconsole->length = 0;
+    console_receive(hconsole);
+}
+
+/*
+ * log command, see console.h
+ */
+static void console_cmd_log(uint8_t argc, char* argv[])
+{
+    if(1 == argc)
+    {
+        log_print_masks();
+        return;
+    }
+    if(3 != argc)
+    {
+        printf("usage: log <channel|all> <level|0xmask>\r\n");
+        return;
+    }
+
+    int16_t mask = -1;
+    if('0' == argv[2][0])
+    {
+        mask = (int16_t)strtol(argv[2], NULL, 0) & LOG_MASK_FROM(LOG_DEBUG);
+    }
+    for(uint8_t level = LOG_DEBUG; level <= LOG_OFF; level++)
+    {
+        if(0 == strcmp(argv[2], console_level_names[level]))
+        {
+            mask = LOG_MASK_FROM(level);
+        }
+    }
+    if(0 > mask || HAL_OK != log_set_mask(argv[1], (uint8_t)mask))
+    {
+        printf("unknown channel or level\r\n");
+        return;
+    }
+    log_print_masks();
+}
+
+/*
+ * splits line at spaces and runs the command
+ */
+static void console_execute(Console_HandleTypeDef_t* hconsole)
+{
+    char* argv[CONSOLE_MAX_ARGS];
+    uint8_t argc = 0;
+    char* token = strtok(hconsole->line, " ");
+    while(NULL != token && CONSOLE_MAX_ARGS > argc)
+    {
+        argv[argc++] = token;
+        token = strtok(NULL, " ");
+    }
+    if(0 == argc)
+    {
+        return;
+    }
+
+    if(0 == strcmp(argv[0], "log"))
+    {
+        console_cmd_log(argc, argv);
+    }
+    else if(0 == strcmp(argv[0], "dump"))
+    {
+        if(HAL_OK != firing_log_dump())
+        {
+            printf("no firing log\r\n");
+        }
+    }
+    else if(0 == strcmp(argv[0], "sim") && 2 == argc)
+    {
+        int acceleration = (0 == strcmp(argv[1], "off")) ? 0 : atoi(argv[1]);
+        if((0 == acceleration && 0 != strcmp(argv[1], "off")) || 0 > acceleration || SIM_MAX_ACCELERATION < acceleration
+                || HAL_OK != simulation_set((uint8_t)acceleration))
+        {
+            printf("sim: 1..%u or off, not while firing\r\n", SIM_MAX_ACCELERATION);
+        }
+    }
+    else if(0 == strcmp(argv[0], "shadow"))
+    {
+        if(2 == argc && 0 == strcmp(argv[1], "off"))
+        {
+            shadow_set(0, 0, 0, 0);
+        }
+        else if(4 == argc)
+        {
+            if(HAL_OK != shadow_set(1, strtof(argv[1], NULL), strtof(argv[2], NULL), strtof(argv[3], NULL)))
+            {
+                printf("shadow: no controller to follow\r\n");
+            }
+        }
+        shadow_log_stats();
+    }
+    else if(0 == strcmp(argv[0], "dma"))
+    {
+        dma_log_stats();
+    }
+    else if(0 == strcmp(argv[0], "cycle"))
+    {
+        cycle_log_stats();
+    }
+    else if(0 == strcmp(argv[0], "bench"))
+    {
+        ramfunc_benchmark();
+    }
+    else if(0 == strcmp(argv[0], "pool"))
+    {
+        pool_print_stats();
+    }
+    else if(0 == strcmp(argv[0], "blackbox"))
+    {
+        blackbox_log_dump();
+    }
+    else
+    {
+        LOG_MSG(LOG_WARNING, "unknown command: %s", argv[0]);
+    }
+}
+
+/*
+ * executes a finished line, called from main loop
+ */
+void console_process(Console_HandleTypeDef_t* hconsole)
+{
+    if(!hconsole->line_ready)
+    {
+        return;
+    }
+    console_execute(hconsole);
+    hconsole->length = 0;
+    hconsole->line_ready = 0;
+    console_receive(hconsole);
+}
@@ -0,0 +1,175 @@
+/*
+ * cycletime.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "cycletime.h"
+#include "log.h"
+
+#define LOG_CHANNEL LOG_CH_HEATER
+
+//[C] upper limits of the bands, the last one is open
+static const float32_t cycletime_band_limits[CYCLETIME_BANDS - 1] = {300.0f, 600.0f, 900.0f};
+
+/*
+ * init function of optimiser, starts from the default response in all bands
+ */
+HAL_StatusTypeDef initCycletime(Cycletime_HandleTypeDef_t* hct, Heater_HandleTypeDef_t* hheater)
+{
+    if(NULL == hct || NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    for(uint8_t i = 0; i < CYCLETIME_BANDS; i++)
+    {
+        hct->response[i] = CYCLETIME_DEFAULT_RESPONSE;
+        hct->window[i] = hheater->cycle_time;
+    }
+    hct->band = 0;
+    hct->op_rate = 0;
+    hct->op_cycle = 0;
+    hct->ops = 0;
+    hct->ticks = 0;
+    hct->last_outputs = heater_get_outputs(hheater);
+    hct->level = hheater->heater_level;
+    hct->prev_level = hheater->heater_level;
+    hct->prev_slope = 0;
+    hct->prev_valid = 0;
+    hct->last_window = hheater->window_count;
+    hct->hheater = hheater;
+    return HAL_OK;
+}
+
+/*
+ * band of a temperature, stays in the current band within the hysteresis
+ */
+static uint8_t cycletime_get_band(Cycletime_HandleTypeDef_t* hct, float32_t temperature)
+{
+    uint8_t band = 0;
+    while(CYCLETIME_BANDS - 1 > band && temperature >= cycletime_band_limits[band])
+    {
+        band++;
+    }
+    if(band > hct->band && temperature < cycletime_band_limits[band - 1] + CYCLETIME_BAND_HYSTERESIS)
+    {
+        band = hct->band;
+    }
+    if(band < hct->band && temperature > cycletime_band_limits[band] - CYCLETIME_BAND_HYSTERESIS)
+    {
+        band = hct->band;
+    }
+    return band;
+}
+
+/*
+ * averages response from the change of slope between the last two windows
+ */
+static void cycletime_measure(Cycletime_HandleTypeDef_t* hct, uint8_t band)
+{
+    float32_t slope = hct->hheater->slope;
+    int8_t step = (int8_t)hct->level - (int8_t)hct->prev_level;
+    if(hct->prev_valid && 0 != step)
+    {
+        float32_t response = (slope - hct->prev_slope) / 3600.0f / step;
+        if(0 < response)
+        {
+            hct->response[band] += (response - hct->response[band]) / CYCLETIME_RESPONSE_WEIGHT;
+        }
+    }
+    hct->prev_slope = slope;
+    hct->prev_level = hct->level;
+    hct->prev_valid = 1;
+}
+
+/*
+ * longest cycle within the ripple bound, lengthened to keep the relay budget.
+ * Rounded to a divisor of the pid interval, down unless that falls below the minimum
+ */
+static uint8_t cycletime_choose(Cycletime_HandleTypeDef_t* hct, uint8_t band)
+{
+    float32_t window = CYCLETIME_RIPPLE / (2.0f * hct->response[band]);
+    float32_t budget = (float32_t)hct->op_cycle / CYCLETIME_RELAY_BUDGET;
+    window = (budget > window) ? budget : window;
+
+    uint8_t pid_interval = hct->hheater->pid_interval;
+    uint8_t cycle = pid_interval;
+    if(window < cycle)
+    {
+        cycle = (CYCLETIME_MIN_SECONDS > window) ? CYCLETIME_MIN_SECONDS : (uint8_t)window;
+    }
+    if(CYCLETIME_MAX_SECONDS < cycle)
+    {
+        cycle = CYCLETIME_MAX_SECONDS;
+    }
+    uint8_t down = cycle;
+    while(0 != pid_interval % down)
+    {
+        down--;
+    }
+    if(CYCLETIME_MIN_SECONDS <= down)
+    {
+        return down;
+    }
+    while(cycle < pid_interval && 0 != pid_interval % cycle)
+    {
+        cycle++;
+    }
+    return cycle;
+}
+
+/*
+ * counts relay operations every tick, at the end of a pid window measures the
+ * response and sets the cycle time of the band
+ */
+void cycletime_on_interupt(Cycletime_HandleTypeDef_t* hct)
+{
+    Heater_HandleTypeDef_t* hheater = hct->hheater;
+    uint8_t outputs = heater_get_outputs(hheater);
+    hct->ops += heater_count_switches(hct->last_outputs, outputs);
+    hct->last_outputs = outputs;
+    hct->ticks += INTERUPT_INTERVAL_SECONDS;
+
+    if(hct->last_window == hheater->window_count)
+    {
+        return;
+    }
+    hct->last_window = hheater->window_count;
+
+    //rate times cycle time does not change with the cycle time, averages over changes
+    uint32_t rate = (uint32_t)hct->ops * 3600U / hct->ticks;
+    hct->op_rate = (hct->op_rate * (CYCLETIME_RATE_WEIGHT - 1) + rate) / CYCLETIME_RATE_WEIGHT;
+    hct->op_cycle = (hct->op_cycle * (CYCLETIME_RATE_WEIGHT - 1) + rate * hheater->cycle_time) / CYCLETIME_RATE_WEIGHT;
+    hct->ops = 0;
+    hct->ticks = 0;
+
+    uint8_t band = cycletime_get_band(hct, hheater->mean);
+    cycletime_measure(hct, band);
+    //level the pid set for the next window
+    hct->level = hheater->heater_level;
+    hct->band = band;
+    hct->window[band] = cycletime_choose(hct, band);
+
+    if(hheater->control_enabled && hct->window[band] != hheater->cycle_pending)
+    {
+        LOG_MSG(LOG_INFO, "CYCLE,%u,%u,%.4f,%lu", band, hct->window[band], hct->response[band],
+                (unsigned long)hct->op_rate);
+        heater_set_cycle_time(hheater, hct->window[band]);
+    }
+}
+
+/*
+ * prints response and cycle time of all bands and the relay operation rate
+ */
+void cycletime_print_stats(Cycletime_HandleTypeDef_t* hct)
+{
+    for(uint8_t i = 0; i < CYCLETIME_BANDS; i++)
+    {
+        printf("%c<%4d C resp %.4f C/s cycle %u s\r\n", (i == hct->band) ? '*' : ' ',
+                (CYCLETIME_BANDS - 1 > i) ? (int)cycletime_band_limits[i] : 9999,
+                hct->response[i], hct->window[i]);
+    }
+    printf("cycle %u s ops %lu/h budget %u/h\r\n", hct->hheater->cycle_time,
+            (unsigned long)hct->op_rate, CYCLETIME_RELAY_BUDGET);
+}
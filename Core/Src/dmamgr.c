@@ -0,0 +1,284 @@
+/*
+ * dmamgr.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "dmamgr.h"
+#include <stdio.h>
+
+/*
+ * fixed mapping of a request
+ */
+typedef struct
+{
+    const char* name;
+    uint8_t channel;            //channel index without remap
+    uint8_t remap_channel;      //channel index with remap, same as channel if there is none
+    uint32_t remap;             //SYSCFG_CFGR1 remap bit, 0 if none
+    volatile void* data;        //peripheral data register
+    volatile uint32_t* enable;  //peripheral register with the DMA enable bit
+    uint32_t enable_bit;
+    uint8_t to_memory;
+}dmamgr_request_info_t;
+
+static const dmamgr_request_info_t dmamgr_requests[DMAMGR_REQ_COUNT] =
+{
+    [DMAMGR_REQ_ADC]       = {"adc",       0, 1, SYSCFG_CFGR1_ADC_DMA_RMP,      &ADC1->DR,      &ADC1->CFGR1,  ADC_CFGR1_DMAEN,   1},
+    [DMAMGR_REQ_SPI2_RX]   = {"spi2_rx",   3, 3, 0,                             &SPI2->DR,      &SPI2->CR2,    SPI_CR2_RXDMAEN,   1},
+    [DMAMGR_REQ_SPI2_TX]   = {"spi2_tx",   4, 4, 0,                             &SPI2->DR,      &SPI2->CR2,    SPI_CR2_TXDMAEN,   0},
+    [DMAMGR_REQ_USART1_TX] = {"usart1_tx", 1, 3, SYSCFG_CFGR1_USART1TX_DMA_RMP, &USART1->TDR,   &USART1->CR3,  USART_CR3_DMAT,    0},
+    [DMAMGR_REQ_USART1_RX] = {"usart1_rx", 2, 4, SYSCFG_CFGR1_USART1RX_DMA_RMP, &USART1->RDR,   &USART1->CR3,  USART_CR3_DMAR,    1},
+    [DMAMGR_REQ_I2C1_TX]   = {"i2c1_tx",   1, 1, 0,                             &I2C1->TXDR,    &I2C1->CR1,    I2C_CR1_TXDMAEN,   0},
+    [DMAMGR_REQ_I2C1_RX]   = {"i2c1_rx",   2, 2, 0,                             &I2C1->RXDR,    &I2C1->CR1,    I2C_CR1_RXDMAEN,   1},
+};
+
+static DMA_Channel_TypeDef* const dmamgr_channel_regs[DMAMGR_CHANNELS] =
+{
+    DMA1_Channel1, DMA1_Channel2, DMA1_Channel3, DMA1_Channel4, DMA1_Channel5
+};
+
+//hardware channel priority per manager priority: very high, high, medium
+static const uint32_t dmamgr_channel_priority[] =
+{
+    DMA_CCR_PL_1 | DMA_CCR_PL_0, DMA_CCR_PL_1, DMA_CCR_PL_0
+};
+
+/*
+ * init function of manager, enables DMA and its interrupts, clears counters
+ */
+HAL_StatusTypeDef initDmamgr(Dmamgr_HandleTypeDef_t* hdma)
+{
+    if(NULL == hdma)
+    {
+        return HAL_ERROR;
+    }
+    for(uint8_t i = 0; i < DMAMGR_CHANNELS; i++)
+    {
+        hdma->channels[i].active = NULL;
+        hdma->channels[i].transfers = 0;
+        hdma->channels[i].items = 0;
+        hdma->channels[i].busy_ms = 0;
+        hdma->channels[i].errors = 0;
+    }
+    hdma->queue = NULL;
+    hdma->done = NULL;
+    hdma->since = HAL_GetTick();
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Channel4_5_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel4_5_IRQn);
+    return HAL_OK;
+}
+
+/*
+ * returns 1 if a transfer of request is running
+ */
+static uint8_t dmamgr_request_active(Dmamgr_HandleTypeDef_t* hdma, dmamgr_request_t request)
+{
+    for(uint8_t i = 0; i < DMAMGR_CHANNELS; i++)
+    {
+        if(NULL != hdma->channels[i].active && request == hdma->channels[i].active->request)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * programs channel and peripheral for transfer and starts it
+ */
+static void dmamgr_start(Dmamgr_HandleTypeDef_t* hdma, uint8_t index, dmamgr_transfer_t* transfer)
+{
+    const dmamgr_request_info_t* info = &dmamgr_requests[transfer->request];
+    DMA_Channel_TypeDef* channel = dmamgr_channel_regs[index];
+
+    if(0 != info->remap)
+    {
+        if(index == info->remap_channel)
+        {
+            SYSCFG->CFGR1 |= info->remap;
+        }
+        else
+        {
+            SYSCFG->CFGR1 &= ~info->remap;
+        }
+    }
+
+    uint32_t size = (2 == transfer->width) ? (DMA_CCR_MSIZE_0 | DMA_CCR_PSIZE_0) : 0;
+    channel->CCR = 0;
+    channel->CPAR = (uint32_t)info->data;
+    channel->CMAR = (uint32_t)transfer->buffer;
+    channel->CNDTR = transfer->length;
+    channel->CCR = size | DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_TEIE
+            | dmamgr_channel_priority[transfer->priority] | (info->to_memory ? 0 : DMA_CCR_DIR);
+
+    hdma->channels[index].active = transfer;
+    hdma->channels[index].start_tick = HAL_GetTick();
+    transfer->state = DMAMGR_ACTIVE;
+    channel->CCR |= DMA_CCR_EN;
+    *info->enable |= info->enable_bit;
+}
+
+/*
+ * starts all waiting transfers that find their request idle and a channel free,
+ * highest priority first. Runs with interrupts disabled
+ */
+static void dmamgr_dispatch(Dmamgr_HandleTypeDef_t* hdma)
+{
+    dmamgr_transfer_t** link = &hdma->queue;
+    while(NULL != *link)
+    {
+        dmamgr_transfer_t* transfer = *link;
+        const dmamgr_request_info_t* info = &dmamgr_requests[transfer->request];
+        int8_t index = -1;
+        if(!dmamgr_request_active(hdma, transfer->request))
+        {
+            if(NULL == hdma->channels[info->channel].active)
+            {
+                index = info->channel;
+            }
+            else if(NULL == hdma->channels[info->remap_channel].active)
+            {
+                index = info->remap_channel;
+            }
+        }
+        if(0 > index)
+        {
+            link = &transfer->next;
+            continue;
+        }
+        *link = transfer->next;
+        transfer->next = NULL;
+        dmamgr_start(hdma, (uint8_t)index, transfer);
+    }
+}
+
+/*
+ * queues transfer, starts it right away if possible
+ */
+HAL_StatusTypeDef dmamgr_submit(Dmamgr_HandleTypeDef_t* hdma, dmamgr_transfer_t* transfer)
+{
+    if(NULL == hdma || NULL == transfer || DMAMGR_REQ_COUNT <= transfer->request || DMAMGR_PRIO_LCD < transfer->priority
+            || 0 == transfer->length || (1 != transfer->width && 2 != transfer->width))
+    {
+        return HAL_ERROR;
+    }
+    if(DMAMGR_IDLE != transfer->state)
+    {
+        return HAL_BUSY;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    transfer->state = DMAMGR_QUEUED;
+    transfer->next = NULL;
+    dmamgr_transfer_t** link = &hdma->queue;
+    while(NULL != *link && (*link)->priority <= transfer->priority)
+    {
+        link = &(*link)->next;
+    }
+    transfer->next = *link;
+    *link = transfer;
+    dmamgr_dispatch(hdma);
+    if(!primask)
+    {
+        __enable_irq();
+    }
+    return HAL_OK;
+}
+
+/*
+ * finishes transfers of all channels with a complete or error flag, then starts
+ * waiting transfers. Called from the DMA1 interrupt handlers
+ */
+void dmamgr_on_interupt(Dmamgr_HandleTypeDef_t* hdma)
+{
+    uint32_t isr = DMA1->ISR;
+    for(uint8_t i = 0; i < DMAMGR_CHANNELS; i++)
+    {
+        uint32_t flags = (isr >> (4U * i)) & (DMA_ISR_TCIF1 | DMA_ISR_TEIF1);
+        dmamgr_channel_t* channel = &hdma->channels[i];
+        if(0 == flags || NULL == channel->active)
+        {
+            continue;
+        }
+        DMA1->IFCR = DMA_IFCR_CGIF1 << (4U * i);
+
+        dmamgr_transfer_t* transfer = channel->active;
+        const dmamgr_request_info_t* info = &dmamgr_requests[transfer->request];
+        *info->enable &= ~info->enable_bit;
+        dmamgr_channel_regs[i]->CCR &= ~DMA_CCR_EN;
+
+        channel->transfers++;
+        channel->items += transfer->length - dmamgr_channel_regs[i]->CNDTR;
+        channel->busy_ms += HAL_GetTick() - channel->start_tick;
+        transfer->status = HAL_OK;
+        if(flags & DMA_ISR_TEIF1)
+        {
+            channel->errors++;
+            transfer->status = HAL_ERROR;
+        }
+        channel->active = NULL;
+
+        //append, callbacks run in order of completion
+        transfer->state = DMAMGR_DONE;
+        transfer->next = NULL;
+        dmamgr_transfer_t** link = &hdma->done;
+        while(NULL != *link)
+        {
+            link = &(*link)->next;
+        }
+        *link = transfer;
+    }
+    dmamgr_dispatch(hdma);
+}
+
+/*
+ * runs callbacks of finished transfers, called from main loop
+ */
+void dmamgr_process(Dmamgr_HandleTypeDef_t* hdma)
+{
+    while(NULL != hdma->done)
+    {
+        __disable_irq();
+        dmamgr_transfer_t* transfer = hdma->done;
+        hdma->done = transfer->next;
+        __enable_irq();
+
+        transfer->next = NULL;
+        transfer->state = DMAMGR_IDLE;
+        if(NULL != transfer->callback)
+        {
+            transfer->callback(transfer->context, transfer->status);
+        }
+    }
+}
+
+/*
+ * prints counters and utilisation of every channel
+ */
+void dmamgr_print_stats(Dmamgr_HandleTypeDef_t* hdma)
+{
+    uint32_t elapsed = HAL_GetTick() - hdma->since;
+    if(0 == elapsed)
+    {
+        elapsed = 1;
+    }
+    for(uint8_t i = 0; i < DMAMGR_CHANNELS; i++)
+    {
+        dmamgr_channel_t* channel = &hdma->channels[i];
+        dmamgr_transfer_t* active = channel->active;
+        printf("ch%u %-9s n %lu items %lu busy %lu%% err %u\r\n", i + 1,
+                (NULL != active) ? dmamgr_requests[active->request].name : "-",
+                (unsigned long)channel->transfers, (unsigned long)channel->items,
+                (unsigned long)((uint64_t)channel->busy_ms * 100U / elapsed), channel->errors);
+    }
+}
@@ -6,49 +6,54 @@
  */
 #include <event.h>
 #include <stdio.h>
-#include <stdlib.h>
+
+#define LOG_CHANNEL LOG_CH_EVENT
+
+//nodes of all event queues
+POOL_MEMORY(event_pool_memory, sizeof(event_node_t), EVENT_POOL_BLOCKS);
+static Pool_HandleTypeDef_t event_pool;
+
 /*
  * logs type to terminal if event calleback gets called
  */
 static void event_diplay_type(event_type_t event){
-#ifdef EVENT_ENABLE_LOG
     switch (event) {
         case BUT1:
-            logMsg(LOG_INFO, "EVENT: BUT1 event detected");
+            LOG_MSG(LOG_DEBUG, "EVENT: BUT1 event detected");
             break;
         case BUT2:
-            logMsg(LOG_INFO, "EVENT: BUT2 event detected");
+            LOG_MSG(LOG_DEBUG, "EVENT: BUT2 event detected");
             break;
         case BUT3:
-            logMsg(LOG_INFO, "EVENT: BUT3 event detected");
+            LOG_MSG(LOG_DEBUG, "EVENT: BUT3 event detected");
             break;
         case BUT4:
-            logMsg(LOG_INFO, "EVENT: BUT4 event detected");
+            LOG_MSG(LOG_DEBUG, "EVENT: BUT4 event detected");
             break;
         case ENC_BUT:
-            logMsg(LOG_INFO, "EVENT: ENC_BUT event detected");
+            LOG_MSG(LOG_DEBUG, "EVENT: ENC_BUT event detected");
             break;
         case ENC_UP:
-            logMsg(LOG_INFO, "EVENT: ENC_UP event detected");
+            LOG_MSG(LOG_DEBUG, "EVENT: ENC_UP event detected");
             break;
         case ENC_DOWN:
-            logMsg(LOG_INFO, "EVENT: ENC_DOWN event detected");
+            LOG_MSG(LOG_DEBUG, "EVENT: ENC_DOWN event detected");
             break;
         default:
-            logMsg(LOG_WARNING, "EVENT: unknown button event detected: %u", event);
+            LOG_MSG(LOG_WARNING, "EVENT: unknown button event detected: %u", event);
             break;
     }
-#endif
 }
 // Function to initialize the queue
 HAL_StatusTypeDef initEvent(Event_Queue_HandleTypeDef_t* queue) {
     if (queue == NULL) {
-#ifdef EVENT_ENABLE_LOG
-        logMsg(LOG_ERROR, "EVENT: Init failed, queue is empty!\r\n");
-#endif
+        LOG_MSG(LOG_ERROR, "EVENT: Init failed, queue is empty!");
         return HAL_ERROR;
     }
     queue->front = queue->rear = NULL;
+    if (NULL == event_pool.memory) {
+        return initPool(&event_pool, "event", event_pool_memory, sizeof(event_node_t), EVENT_POOL_BLOCKS);
+    }
     return HAL_OK; // Assuming HAL_OK is defined appropriately
 }
 
@@ -57,43 +62,57 @@ uint8_t event_isEmpty(Event_Queue_HandleTypeDef_t* queue) {
     return (queue->front == NULL);
 }
 
-// Function to create a new node
+// Function to create a new node from the event pool, NULL if all nodes are queued
 event_node_t* event_createNode(event_type_t data) {
-    event_node_t* newNode = (event_node_t*)malloc(sizeof(event_node_t));
+    event_node_t* newNode = (event_node_t*)pool_alloc(&event_pool);
     if (newNode == NULL) {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(EXIT_FAILURE);
+        return NULL;
     }
     newNode->data = data;
     newNode->next = NULL;
     return newNode;
 }
 
-// Function to enqueue an event
+// Function to enqueue an event, called from interrupts. Drops the event if the pool is empty
 void event_enqueue(Event_Queue_HandleTypeDef_t* queue, event_type_t event) {
     event_diplay_type(event);
     event_node_t* newNode = event_createNode(event);
+    if (newNode == NULL) {
+        LOG_MSG(LOG_WARNING, "EVENT: queue full, event %u dropped", event);
+        return;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
     if (event_isEmpty(queue)) {
         queue->front = queue->rear = newNode;
     } else {
         queue->rear->next = newNode;
         queue->rear = newNode;
     }
+    if (!primask) {
+        __enable_irq();
+    }
 }
 
-// Function to dequeue an event
+// Function to dequeue an event, NO_EVENT if the queue is empty
 event_type_t event_dequeue(Event_Queue_HandleTypeDef_t* queue) {
-    if (event_isEmpty(queue)) {
-        fprintf(stderr, "Queue is empty\n");
-        exit(EXIT_FAILURE);
-    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
     event_node_t* temp = queue->front;
-    event_type_t data = temp->data;
-    queue->front = queue->front->next;
-    free(temp);
-    if (queue->front == NULL) {
-        queue->rear = NULL;
+    if (temp != NULL) {
+        queue->front = temp->next;
+        if (queue->front == NULL) {
+            queue->rear = NULL;
+        }
     }
+    if (!primask) {
+        __enable_irq();
+    }
+    if (temp == NULL) {
+        return NO_EVENT;
+    }
+    event_type_t data = temp->data;
+    pool_free(&event_pool, temp);
     return data;
 }
 
@@ -0,0 +1,154 @@
+/*
+ * firestats.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "firestats.h"
+
+static void firestats_clear(firestats_acc_t* acc)
+{
+    acc->n = 0;
+    acc->sum = 0;
+    acc->sum_sq = 0;
+    acc->max_error = 0;
+    acc->overshoot = INT16_MIN;
+    acc->time_to_target = FIRESTATS_NOT_REACHED;
+    acc->level_sum = 0;
+    acc->relay_ops = 0;
+    acc->faults = 0;
+}
+
+/*
+ * init function of statistics, nothing recorded afterwards
+ */
+HAL_StatusTypeDef initFirestats(Firestats_HandleTypeDef_t* hstats, Heater_HandleTypeDef_t* hheater)
+{
+    if(NULL == hstats || NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    hstats->hheater = hheater;
+    firestats_clear(&hstats->segment);
+    firestats_clear(&hstats->firing);
+    firestats_summarize(&hstats->firing, &hstats->last);
+    hstats->target = 0;
+    hstats->direction = 1;
+    hstats->target_tick = 0;
+    hstats->last_outputs = 0;
+    hstats->last_fault = 0;
+    return HAL_OK;
+}
+
+/*
+ * clears firing and segment statistics
+ */
+void firestats_start(Firestats_HandleTypeDef_t* hstats)
+{
+    firestats_clear(&hstats->firing);
+    firestats_clear(&hstats->segment);
+    hstats->last_outputs = heater_get_outputs(hstats->hheater);
+    hstats->last_fault = 0;
+}
+
+/*
+ * clears segment statistics for a segment from temperature to target [C]
+ */
+void firestats_begin_segment(Firestats_HandleTypeDef_t* hstats, float32_t from, float32_t target)
+{
+    firestats_clear(&hstats->segment);
+    firestats_set_target(hstats, from, target);
+}
+
+/*
+ * moves the target of the running segment, overshoot and time to target
+ * of the segment start over for the new target
+ */
+void firestats_set_target(Firestats_HandleTypeDef_t* hstats, float32_t from, float32_t target)
+{
+    hstats->target = (int16_t)(target * 16);
+    hstats->direction = (from > target) ? -1 : 1;
+    hstats->target_tick = hstats->segment.n;
+    hstats->segment.overshoot = INT16_MIN;
+    hstats->segment.time_to_target = FIRESTATS_NOT_REACHED;
+}
+
+/*
+ * adds one tick to an accumulator
+ */
+static void firestats_add(firestats_acc_t* acc, int32_t error, int16_t beyond, uint8_t reached,
+        uint8_t level, uint8_t switched, uint8_t fault, uint32_t since)
+{
+    acc->n++;
+    acc->sum += error;
+    acc->sum_sq += (int64_t)error * error;
+
+    uint16_t error_abs = (0 > error) ? -error : error;
+    acc->max_error = (error_abs > acc->max_error) ? error_abs : acc->max_error;
+    acc->overshoot = (beyond > acc->overshoot) ? beyond : acc->overshoot;
+    if(reached && FIRESTATS_NOT_REACHED == acc->time_to_target)
+    {
+        uint32_t time = acc->n - since;
+        acc->time_to_target = (time > FIRESTATS_NOT_REACHED - 1) ? FIRESTATS_NOT_REACHED - 1 : time;
+    }
+    acc->level_sum += level;
+    acc->relay_ops += switched;
+    acc->faults += fault;
+}
+
+/*
+ * adds the current heater state to segment and firing, called every tick
+ */
+void firestats_on_tick(Firestats_HandleTypeDef_t* hstats, float32_t reference)
+{
+    Heater_HandleTypeDef_t* hheater = hstats->hheater;
+    int32_t temperature = (int32_t)(hheater->last_temperature * 16);
+    int32_t error = temperature - (int32_t)(reference * 16);
+    int32_t beyond = (temperature - hstats->target) * hstats->direction;
+    uint8_t reached = (FIRESTATS_BAND * 16 >= ((0 > beyond) ? -beyond : beyond)) || 0 < beyond;
+    if(INT16_MAX < beyond)
+    {
+        beyond = INT16_MAX;
+    }
+    if(INT16_MIN > beyond)
+    {
+        beyond = INT16_MIN;
+    }
+
+    uint8_t outputs = heater_get_outputs(hheater);
+    uint8_t switched = heater_count_switches(hstats->last_outputs, outputs);
+    hstats->last_outputs = outputs;
+
+    uint8_t fault = hheater->htemp->payload.fault || hheater->flag_door_open;
+    uint8_t new_fault = fault && !hstats->last_fault;
+    hstats->last_fault = fault;
+
+    firestats_add(&hstats->segment, error, (int16_t)beyond, reached, hheater->heater_level, switched, new_fault,
+            hstats->target_tick);
+    firestats_add(&hstats->firing, error, (int16_t)beyond, reached, hheater->heater_level, switched, new_fault, 0);
+}
+
+/*
+ * compact summary of an accumulator
+ */
+void firestats_summarize(const firestats_acc_t* acc, firestats_summary_t* summary)
+{
+    uint32_t n = (0 == acc->n) ? 1 : acc->n;
+    //double once per summary, the sums are exact but exceed the 24 bit mantissa of a float
+    double mean = (double)acc->sum / n;
+    double variance = (double)acc->sum_sq / n - mean * mean;
+    float32_t sd = 0;
+    arm_sqrt_f32((0 < variance) ? (float32_t)variance : 0.0f, &sd);
+    uint32_t energy = acc->level_sum * FIRESTATS_LEVEL_POWER_W / 3600U;
+
+    summary->mean_error = (int16_t)((0 > mean) ? mean - 0.5 : mean + 0.5);
+    summary->sd_error = (uint16_t)(sd + 0.5f);
+    summary->max_error = acc->max_error;
+    summary->overshoot = (0 < acc->overshoot) ? acc->overshoot : 0;
+    summary->time_to_target = acc->time_to_target;
+    summary->duty = (uint16_t)(acc->level_sum * 1000U / (n * HEATER_MAX_LEVEL));
+    summary->energy = (UINT16_MAX < energy) ? UINT16_MAX : energy;
+    summary->relay_ops = acc->relay_ops;
+    summary->faults = acc->faults;
+}
@@ -0,0 +1,642 @@
+/*
+ * firing.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "firing.h"
+#include "log.h"
+
+#define LOG_CHANNEL LOG_CH_FIRING
+
+/*
+ * init function of firing instance, firing is idle afterwards
+ */
+HAL_StatusTypeDef initFiring(Firing_HandleTypeDef_t* hfiring, Heater_HandleTypeDef_t* hheater,
+        PID_HandletypeDef_t* hpid, Scheduler_HandleTypeDef_t* hsched)
+{
+    if(NULL == hfiring || NULL == hheater || NULL == hpid)
+    {
+        return HAL_ERROR;
+    }
+    hfiring->mode = FIRING_IDLE;
+    hfiring->target = 0;
+    hfiring->reference = 0;
+    hfiring->max_rate = FIRING_HOLD_MAX_RATE;
+    hfiring->dashboard_dirty = 0;
+    hfiring->elapsed = 0;
+    hfiring->log_counter = 0;
+    hfiring->length = 0;
+    hfiring->segment = 0;
+    hfiring->hold_time = 0;
+    heatwork_reset(&hfiring->heatwork);
+    hfiring->estimating = 0;
+    hfiring->feedforward_gain = 0;
+    hfiring->hheater = hheater;
+    hfiring->hpid = hpid;
+    hfiring->hsched = hsched;
+    hfiring->hlog = NULL;
+    hfiring->hload = NULL;
+    hfiring->hstats = NULL;
+    return HAL_OK;
+}
+
+/*
+ * records all following firings to hlog
+ */
+void firing_attach_log(Firing_HandleTypeDef_t* hfiring, Flashlog_HandleTypeDef_t* hlog)
+{
+    hfiring->hlog = hlog;
+}
+
+/*
+ * estimates the load at the start of following programs
+ */
+void firing_attach_loadest(Firing_HandleTypeDef_t* hfiring, Loadest_HandleTypeDef_t* hload)
+{
+    hfiring->hload = hload;
+}
+
+/*
+ * keeps statistics of all following firings in hstats
+ */
+void firing_attach_stats(Firing_HandleTypeDef_t* hfiring, Firestats_HandleTypeDef_t* hstats)
+{
+    hfiring->hstats = hstats;
+}
+
+/*
+ * queues a sample of the current heater state to the log
+ */
+static void firing_log_sample(Firing_HandleTypeDef_t* hfiring)
+{
+    Heater_HandleTypeDef_t* hheater = hfiring->hheater;
+    flashlog_record_t record = {0};
+
+    record.type = FLASHLOG_REC_SAMPLE;
+    record.level = hheater->heater_level;
+    record.time = hfiring->elapsed;
+    record.temperature = (int16_t)(hheater->last_temperature * 16);
+    record.setpoint = (int16_t)(hfiring->reference * 16);
+    record.slope = (int16_t)hheater->slope;
+    record.data = hfiring->mode | ((uint16_t)hheater->phase_imbalance << 8);
+    flashlog_append(hfiring->hlog, &record);
+}
+
+/*
+ * queues segment index as it is run to the log
+ */
+static void firing_log_segment(Firing_HandleTypeDef_t* hfiring, uint8_t index)
+{
+    flashlog_record_t record = {0};
+
+    if(NULL == hfiring->hlog)
+    {
+        return;
+    }
+    record.type = FLASHLOG_REC_SEGMENT;
+    record.level = index;
+    record.time = hfiring->elapsed;
+    record.temperature = (int16_t)(hfiring->segments[index].target * 16);
+    record.setpoint = (int16_t)(hfiring->reference * 16);
+    record.slope = (int16_t)hfiring->segments[index].gradient;
+    record.data = hfiring->segments[index].hold | ((uint16_t)hfiring->segments[index].cone << 11);
+    flashlog_append(hfiring->hlog, &record);
+}
+
+/*
+ * queues a reached cone to the log
+ */
+static void firing_log_cone(Firing_HandleTypeDef_t* hfiring)
+{
+    LOG_MSG(LOG_INFO, "CONE,%s,%lu", heatwork_cone_name(hfiring->heatwork.cone), (unsigned long)hfiring->elapsed);
+    if(NULL == hfiring->hlog)
+    {
+        return;
+    }
+    flashlog_record_t record = {0};
+    record.type = FLASHLOG_REC_CONE;
+    record.level = hfiring->heatwork.cone;
+    record.time = hfiring->elapsed;
+    record.temperature = (int16_t)(hfiring->hheater->last_temperature * 16);
+    record.setpoint = (int16_t)(hfiring->reference * 16);
+    flashlog_append(hfiring->hlog, &record);
+}
+
+/*
+ * queues a summary as two records to the log, index is the segment or
+ * FLASHLOG_SUMMARY_FIRING. See flashlog.h for the layout
+ */
+static void firing_log_summary(Firing_HandleTypeDef_t* hfiring, uint8_t index, const firestats_summary_t* summary)
+{
+    LOG_MSG(LOG_INFO, "STATS,%u,%d,%u,%u,%d,%u,%u,%u,%u,%u", index, summary->mean_error, summary->sd_error,
+            summary->max_error, summary->overshoot, summary->time_to_target, summary->duty,
+            summary->energy, summary->relay_ops, summary->faults);
+    if(NULL == hfiring->hlog)
+    {
+        return;
+    }
+    flashlog_record_t record = {0};
+    record.type = FLASHLOG_REC_SUMMARY;
+    record.level = index;
+    record.time = hfiring->elapsed;
+    record.temperature = summary->mean_error;
+    record.setpoint = (int16_t)summary->sd_error;
+    record.slope = (int16_t)summary->max_error;
+    record.data = summary->time_to_target;
+    flashlog_append(hfiring->hlog, &record);
+
+    uint8_t faults = (FLASHLOG_SUMMARY_MAX_FAULTS < summary->faults) ? FLASHLOG_SUMMARY_MAX_FAULTS : summary->faults;
+    record.level = index | FLASHLOG_SUMMARY_SECOND;
+    record.temperature = summary->overshoot;
+    record.setpoint = (int16_t)((INT16_MAX < summary->energy) ? INT16_MAX : summary->energy);
+    record.slope = (int16_t)((INT16_MAX < summary->relay_ops) ? INT16_MAX : summary->relay_ops);
+    record.data = summary->duty | ((uint16_t)faults << 10);
+    flashlog_append(hfiring->hlog, &record);
+}
+
+/*
+ * summary of the current segment to the log, nothing if it did not run
+ */
+static void firing_finish_segment(Firing_HandleTypeDef_t* hfiring)
+{
+    if(NULL == hfiring->hstats || 0 == hfiring->hstats->segment.n)
+    {
+        return;
+    }
+    firestats_summary_t summary;
+    firestats_summarize(&hfiring->hstats->segment, &summary);
+    firing_log_summary(hfiring, hfiring->segment, &summary);
+}
+
+/*
+ * hands the current target and the gradient of the reference to the scheduler
+ */
+static void firing_update_scheduler(Firing_HandleTypeDef_t* hfiring)
+{
+    if(NULL == hfiring->hsched)
+    {
+        return;
+    }
+    float32_t gradient = 0;
+    if(hfiring->reference < hfiring->target)
+    {
+        gradient = hfiring->max_rate;
+    }
+    else if(hfiring->reference > hfiring->target)
+    {
+        gradient = -hfiring->max_rate;
+    }
+    scheduler_set_target(hfiring->hsched, hfiring->target, gradient);
+}
+
+/*
+ * common part of all starts: gains, pid state and reference from the current temperature
+ */
+static void firing_start(Firing_HandleTypeDef_t* hfiring, float32_t k_p, float32_t k_i, float32_t k_d)
+{
+    PID_UpdateParameters(hfiring->hpid, k_p, k_i, k_d, hfiring->hpid->hysteresis);
+    PID_Reset(hfiring->hpid, hfiring->hheater->last_temperature);
+
+    hfiring->reference = hfiring->hheater->last_temperature;
+    hfiring->dashboard_dirty = 1;
+    hfiring->elapsed = 0;
+    hfiring->log_counter = 0;
+    heatwork_reset(&hfiring->heatwork);
+    if(NULL != hfiring->hstats)
+    {
+        firestats_start(hfiring->hstats);
+    }
+    if(NULL != hfiring->hlog)
+    {
+        flashlog_start_firing(hfiring->hlog);
+    }
+}
+
+/*
+ * starts hold mode with setpoint gains. Reference starts at the current temperature
+ */
+HAL_StatusTypeDef firing_start_hold(Firing_HandleTypeDef_t* hfiring, float32_t target,
+        float32_t k_p, float32_t k_i, float32_t k_d)
+{
+    if(NULL == hfiring)
+    {
+        return HAL_ERROR;
+    }
+    firing_start(hfiring, k_p, k_i, k_d);
+    hfiring->target = target;
+    hfiring->max_rate = FIRING_HOLD_MAX_RATE;
+    hfiring->segment = 0;
+    hfiring->mode = FIRING_HOLD;
+    if(NULL != hfiring->hstats)
+    {
+        firestats_begin_segment(hfiring->hstats, hfiring->reference, target);
+    }
+
+    firing_update_scheduler(hfiring);
+    return heater_set_setpoint(hfiring->hheater, hfiring->reference);
+}
+
+/*
+ * makes current segment the active ramp
+ */
+static void firing_enter_segment(Firing_HandleTypeDef_t* hfiring)
+{
+    firing_segment_t* segment = &hfiring->segments[hfiring->segment];
+    hfiring->target = segment->target;
+    hfiring->max_rate = segment->gradient;
+    hfiring->hold_time = 0;
+    if(NULL != hfiring->hstats)
+    {
+        firestats_begin_segment(hfiring->hstats, hfiring->reference, segment->target);
+    }
+}
+
+/*
+ * recomputes planned end of segments from index on, segments before it are untouched.
+ * The current segment is planned from the reference and the hold time already spent
+ */
+static void firing_plan(Firing_HandleTypeDef_t* hfiring, uint8_t index)
+{
+    uint32_t time;
+    float32_t from;
+    uint32_t hold_spent = 0;
+
+    if(index == hfiring->segment)
+    {
+        time = hfiring->elapsed;
+        from = hfiring->reference;
+        hold_spent = hfiring->hold_time;
+    }
+    else
+    {
+        time = hfiring->segment_end[index - 1];
+        from = hfiring->segments[index - 1].target;
+    }
+
+    for(uint8_t i = index; i < hfiring->length; i++)
+    {
+        firing_segment_t* segment = &hfiring->segments[i];
+        if(0 != segment->gradient)
+        {
+            time += (uint32_t)(fabsf(segment->target - from) * 3600.0f / segment->gradient);
+        }
+        uint32_t hold = segment->hold * 60U;
+        time += (hold > hold_spent) ? hold - hold_spent : 0;
+        hold_spent = 0;
+        hfiring->segment_end[i] = time;
+        from = segment->target;
+    }
+}
+
+/*
+ * scales gains with the load factor and sets the feed forward gain,
+ * the pid keeps its state so it is bumpless
+ */
+static void firing_apply_load(Firing_HandleTypeDef_t* hfiring)
+{
+    float32_t factor = 1.0f;
+    hfiring->feedforward_gain = 0;
+    if(NULL != hfiring->hload)
+    {
+        factor = hfiring->hload->factor;
+        hfiring->feedforward_gain = loadest_get_feedforward_gain(hfiring->hload);
+    }
+    PID_UpdateParameters(hfiring->hpid, hfiring->k_p * factor, hfiring->k_i * factor, hfiring->k_d * factor,
+            hfiring->hpid->hysteresis);
+}
+
+/*
+ * logs result of the load estimation with the firing
+ */
+static void firing_log_load(Firing_HandleTypeDef_t* hfiring)
+{
+    Loadest_HandleTypeDef_t* hload = hfiring->hload;
+    LOG_MSG(LOG_INFO, "LOAD,%.1f,%.2f,%u", hload->slope, hload->factor, hload->load_class);
+    if(NULL == hfiring->hlog)
+    {
+        return;
+    }
+    flashlog_record_t record = {0};
+    record.type = FLASHLOG_REC_LOAD;
+    record.level = hload->load_class;
+    record.time = hfiring->elapsed;
+    record.temperature = (int16_t)(hfiring->hheater->last_temperature * 16);
+    record.slope = (int16_t)hload->slope;
+    record.data = (uint16_t)(hload->factor * 100);
+    flashlog_append(hfiring->hlog, &record);
+}
+
+/*
+ * starts program mode with gradient gains. Reference starts at the current temperature,
+ * a program that starts by heating measures the load first if an estimator is attached
+ */
+HAL_StatusTypeDef firing_start_program(Firing_HandleTypeDef_t* hfiring, const firing_segment_t* segments,
+        uint8_t length, float32_t k_p, float32_t k_i, float32_t k_d)
+{
+    if(NULL == hfiring || NULL == segments || 0 == length || FIRING_MAX_SEGMENTS < length)
+    {
+        return HAL_ERROR;
+    }
+    for(uint8_t i = 0; i < length; i++)
+    {
+        hfiring->segments[i] = segments[i];
+    }
+    hfiring->length = length;
+    hfiring->segment = 0;
+
+    hfiring->k_p = k_p;
+    hfiring->k_i = k_i;
+    hfiring->k_d = k_d;
+
+    firing_start(hfiring, k_p, k_i, k_d);
+    firing_enter_segment(hfiring);
+    firing_plan(hfiring, 0);
+    hfiring->mode = FIRING_PROGRAM;
+    for(uint8_t i = 0; i < length; i++)
+    {
+        firing_log_segment(hfiring, i);
+    }
+
+    hfiring->estimating = 0;
+    if(NULL != hfiring->hload && segments[0].target > hfiring->reference + LOADEST_MIN_RISE
+            && HAL_OK == loadest_start(hfiring->hload))
+    {
+        hfiring->estimating = 1;
+        return HAL_OK;
+    }
+    //uses the last estimate, nominal load if there is none
+    firing_apply_load(hfiring);
+    firing_update_scheduler(hfiring);
+    return heater_set_setpoint(hfiring->hheater, hfiring->reference);
+}
+
+/*
+ * replaces current or a future segment of the running program.
+ * Reference and pid are not touched, the ramp continues from where it is
+ * with the new values. A new target restarts the hold of the current segment
+ */
+HAL_StatusTypeDef firing_edit_segment(Firing_HandleTypeDef_t* hfiring, uint8_t index, const firing_segment_t* segment)
+{
+    if(NULL == hfiring || NULL == segment || FIRING_PROGRAM != hfiring->mode)
+    {
+        return HAL_ERROR;
+    }
+
+    //runs against firing_on_interupt
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    HAL_StatusTypeDef status = HAL_ERROR;
+    if(index >= hfiring->segment && index < hfiring->length)
+    {
+        uint16_t old_target = hfiring->segments[index].target;
+        hfiring->segments[index] = *segment;
+        if(index == hfiring->segment)
+        {
+            hfiring->target = segment->target;
+            hfiring->max_rate = segment->gradient;
+            if(old_target != segment->target)
+            {
+                hfiring->hold_time = 0;
+            }
+        }
+        firing_plan(hfiring, index);
+        firing_log_segment(hfiring, index);
+        hfiring->dashboard_dirty = 1;
+        status = HAL_OK;
+    }
+    if(!primask)
+    {
+        __enable_irq();
+    }
+    return status;
+}
+
+/*
+ * returns planned time until the program ends [s], 0 if no program runs
+ */
+uint32_t firing_get_remaining(Firing_HandleTypeDef_t* hfiring)
+{
+    if(FIRING_PROGRAM != hfiring->mode)
+    {
+        return 0;
+    }
+    uint32_t end = hfiring->segment_end[hfiring->length - 1];
+    return (end > hfiring->elapsed) ? end - hfiring->elapsed : 0;
+}
+
+/*
+ * changes target of a running hold, takes effect with the next interrupt.
+ * A program changes its targets with firing_edit_segment
+ */
+HAL_StatusTypeDef firing_set_target(Firing_HandleTypeDef_t* hfiring, float32_t target)
+{
+    if(NULL == hfiring || FIRING_HOLD != hfiring->mode)
+    {
+        return HAL_ERROR;
+    }
+    //runs against firing_on_interupt
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    hfiring->target = target;
+    if(NULL != hfiring->hstats)
+    {
+        firestats_set_target(hfiring->hstats, hfiring->reference, target);
+    }
+    if(!primask)
+    {
+        __enable_irq();
+    }
+    hfiring->dashboard_dirty = 1;
+    return HAL_OK;
+}
+
+/*
+ * stops firing and turns heater off
+ */
+HAL_StatusTypeDef firing_stop(Firing_HandleTypeDef_t* hfiring)
+{
+    if(NULL == hfiring)
+    {
+        return HAL_ERROR;
+    }
+    //called from the ui, runs against firing_on_interupt
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if(NULL != hfiring->hstats && FIRING_IDLE != hfiring->mode)
+    {
+        firing_finish_segment(hfiring);
+        firestats_summarize(&hfiring->hstats->firing, &hfiring->hstats->last);
+        firing_log_summary(hfiring, FLASHLOG_SUMMARY_FIRING, &hfiring->hstats->last);
+    }
+    if(NULL != hfiring->hlog && FIRING_IDLE != hfiring->mode)
+    {
+        flashlog_end_firing(hfiring->hlog);
+    }
+    if(hfiring->estimating)
+    {
+        loadest_stop(hfiring->hload);
+        hfiring->estimating = 0;
+    }
+    hfiring->mode = FIRING_IDLE;
+    hfiring->dashboard_dirty = 1;
+    if(NULL != hfiring->hsched)
+    {
+        scheduler_clear_target(hfiring->hsched);
+    }
+    HAL_StatusTypeDef status = heater_disable_control(hfiring->hheater);
+    if(!primask)
+    {
+        __enable_irq();
+    }
+    return status;
+}
+
+uint8_t firing_is_running(Firing_HandleTypeDef_t* hfiring)
+{
+    return (FIRING_IDLE != hfiring->mode);
+}
+
+/*
+ * returns 1 once after the firing changed values shown on the dashboard
+ */
+uint8_t firing_take_dashboard_update(Firing_HandleTypeDef_t* hfiring)
+{
+    if(!hfiring->dashboard_dirty)
+    {
+        return 0;
+    }
+    hfiring->dashboard_dirty = 0;
+    return 1;
+}
+
+/*
+ * counts hold time at target, moves on to the next segment or ends the program.
+ * A cone segment ends its hold early once the cone is reached. Returns 0 if the program ended
+ */
+static uint8_t firing_step_program(Firing_HandleTypeDef_t* hfiring)
+{
+    if(hfiring->reference != hfiring->target)
+    {
+        return 1;
+    }
+    firing_segment_t* segment = &hfiring->segments[hfiring->segment];
+    uint8_t matured = (0 != segment->cone && heatwork_is_reached(&hfiring->heatwork, segment->cone));
+    hfiring->hold_time += INTERUPT_INTERVAL_SECONDS;
+    if(!matured && segment->hold * 60U > hfiring->hold_time)
+    {
+        return 1;
+    }
+    if(hfiring->length <= hfiring->segment + 1)
+    {
+        firing_stop(hfiring);
+        return 0;
+    }
+    firing_finish_segment(hfiring);
+    hfiring->segment++;
+    firing_enter_segment(hfiring);
+    return 1;
+}
+
+/*
+ * counts firing time and logs samples, called every RTC interrupt while running
+ */
+static void firing_count_time(Firing_HandleTypeDef_t* hfiring)
+{
+    hfiring->elapsed += INTERUPT_INTERVAL_SECONDS;
+    hfiring->log_counter += INTERUPT_INTERVAL_SECONDS;
+
+    uint8_t cone = hfiring->heatwork.cone;
+    heatwork_add(&hfiring->heatwork, hfiring->hheater->last_temperature, INTERUPT_INTERVAL_SECONDS);
+    if(cone != hfiring->heatwork.cone)
+    {
+        firing_log_cone(hfiring);
+    }
+    if(NULL != hfiring->hlog && hfiring->hheater->log_interval <= hfiring->log_counter)
+    {
+        hfiring->log_counter = 0;
+        firing_log_sample(hfiring);
+    }
+}
+
+/*
+ * runs load estimation, afterwards the program starts from the current temperature
+ * with scaled gains. Returns 1 while estimating
+ */
+static uint8_t firing_estimate_load(Firing_HandleTypeDef_t* hfiring)
+{
+    if(!loadest_on_interupt(hfiring->hload))
+    {
+        firing_count_time(hfiring);
+        hfiring->dashboard_dirty = 1;
+        return 1;
+    }
+    hfiring->estimating = 0;
+    firing_apply_load(hfiring);
+    firing_log_load(hfiring);
+
+    PID_Reset(hfiring->hpid, hfiring->hheater->last_temperature);
+    hfiring->reference = hfiring->hheater->last_temperature;
+    firing_enter_segment(hfiring);
+    firing_plan(hfiring, hfiring->segment);
+    return 0;
+}
+
+/*
+ * moves reference by at most max_rate towards target, called every RTC interrupt
+ */
+void firing_on_interupt(Firing_HandleTypeDef_t* hfiring)
+{
+    if(FIRING_IDLE == hfiring->mode)
+    {
+        return;
+    }
+    if(hfiring->estimating && firing_estimate_load(hfiring))
+    {
+        return;
+    }
+    if(FIRING_PROGRAM == hfiring->mode && !firing_step_program(hfiring))
+    {
+        return;
+    }
+
+    //feed forward while heating along a ramp
+    if(FIRING_PROGRAM == hfiring->mode)
+    {
+        float32_t feedforward = 0;
+        if(hfiring->target > hfiring->reference)
+        {
+            feedforward = hfiring->max_rate * hfiring->feedforward_gain;
+        }
+        heater_set_feedforward(hfiring->hheater, feedforward);
+    }
+
+    float32_t step = hfiring->max_rate * INTERUPT_INTERVAL_SECONDS / 3600.0f;
+    float32_t diff = hfiring->target - hfiring->reference;
+    if(0 == hfiring->max_rate)
+    {
+        hfiring->reference = hfiring->target;
+    }
+    else if(step < diff)
+    {
+        hfiring->reference += step;
+    }
+    else if(-step > diff)
+    {
+        hfiring->reference -= step;
+    }
+    else
+    {
+        hfiring->reference = hfiring->target;
+    }
+
+    firing_update_scheduler(hfiring);
+    heater_set_setpoint(hfiring->hheater, hfiring->reference);
+    hfiring->dashboard_dirty = 1;
+    if(NULL != hfiring->hstats)
+    {
+        firestats_on_tick(hfiring->hstats, hfiring->reference);
+    }
+    firing_count_time(hfiring);
+}
@@ -0,0 +1,426 @@
+/*
+ * flashlog.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ *
+ *      No HAL calls in here, all flash access goes through the device so the
+ *      log can run against the file backed stand-in on a host.
+ */
+
+#include "flashlog.h"
+#include <string.h>
+
+//queue is filled from interrupts and main loop
+#ifdef FLASHLOG_HOST
+#define FLASHLOG_LOCK()
+#define FLASHLOG_UNLOCK()
+#else
+#define FLASHLOG_LOCK() uint32_t flashlog_primask = __get_PRIMASK(); __disable_irq()
+#define FLASHLOG_UNLOCK() if(!flashlog_primask) { __enable_irq(); }
+#endif
+
+#define FLASHLOG_ENTRY_SIZE 16
+#define FLASHLOG_CHECK_SEED 0xA5
+
+/*
+ * xor over all bytes of an index entry except the check byte
+ */
+static uint8_t flashlog_index_check(const flashlog_index_t* entry)
+{
+    const uint8_t* bytes = (const uint8_t*)entry;
+    uint8_t check = FLASHLOG_CHECK_SEED;
+    for(uint8_t i = 0; i < sizeof(flashlog_index_t); i++)
+    {
+        if(offsetof(flashlog_index_t, check) != i)
+        {
+            check ^= bytes[i];
+        }
+    }
+    return check;
+}
+
+static HAL_StatusTypeDef flashlog_read_index(Flashlog_HandleTypeDef_t* hlog, uint32_t addr, flashlog_index_t* entry)
+{
+    return hlog->dev->read(hlog->dev->ctx, addr, (uint8_t*)entry, sizeof(flashlog_index_t));
+}
+
+static HAL_StatusTypeDef flashlog_read_record(Flashlog_HandleTypeDef_t* hlog, uint32_t addr, flashlog_record_t* record)
+{
+    return hlog->dev->read(hlog->dev->ctx, addr, (uint8_t*)record, sizeof(flashlog_record_t));
+}
+
+/*
+ * returns 1 if entry was completely written
+ */
+static uint8_t flashlog_index_valid(const flashlog_index_t* entry)
+{
+    return (FLASHLOG_ERASED_SEQ != entry->seq && flashlog_index_check(entry) == entry->check);
+}
+
+static uint32_t flashlog_next_data_addr(Flashlog_HandleTypeDef_t* hlog, uint32_t addr)
+{
+    addr += FLASHLOG_ENTRY_SIZE;
+    return (hlog->dev->size <= addr) ? FLASHLOG_DATA_START : addr;
+}
+
+/*
+ * resets handle to an empty log
+ */
+static void flashlog_set_empty(Flashlog_HandleTypeDef_t* hlog)
+{
+    hlog->index_addr = 0;
+    hlog->index_seq = 0;
+    hlog->index_erased_addr = FLASHLOG_NO_ADDR;
+    hlog->write_addr = FLASHLOG_DATA_START;
+    hlog->block_erased_addr = FLASHLOG_NO_ADDR;
+    hlog->mark_addr = FLASHLOG_NO_ADDR;
+    hlog->start_addr = FLASHLOG_DATA_START;
+    hlog->firing_id = 0;
+    hlog->firing_active = 0;
+}
+
+/*
+ * finds the first free record in the data block that entry points to.
+ * Records of the entry's firing form a prefix of the block, binary search for its end
+ */
+static uint32_t flashlog_recover_write_addr(Flashlog_HandleTypeDef_t* hlog, const flashlog_index_t* entry)
+{
+    flashlog_record_t record;
+    uint32_t base = entry->addr;
+    uint32_t block_end = (base & ~(FLASHLOG_BLOCK_SIZE - 1U)) + FLASHLOG_BLOCK_SIZE;
+
+    if(FLASHLOG_INDEX_END == entry->type)
+    {
+        return (hlog->dev->size <= base) ? FLASHLOG_DATA_START : base;
+    }
+
+    uint32_t lo = 0;
+    uint32_t hi = (block_end - base) / FLASHLOG_ENTRY_SIZE;
+    while(lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        flashlog_read_record(hlog, base + mid * FLASHLOG_ENTRY_SIZE, &record);
+        if(entry->firing_id == record.firing_id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    uint32_t addr = base + lo * FLASHLOG_ENTRY_SIZE;
+    if(block_end > addr)
+    {
+        //stale data from an interrupted erase, continue in the next block
+        flashlog_read_record(hlog, addr, &record);
+        if(FLASHLOG_ERASED_ID != record.firing_id)
+        {
+            addr = block_end;
+        }
+    }
+    return (hlog->dev->size <= addr) ? FLASHLOG_DATA_START : addr;
+}
+
+/*
+ * init function of log instance, recovers the write position from the index
+ */
+HAL_StatusTypeDef initFlashlog(Flashlog_HandleTypeDef_t* hlog, const flashlog_device_t* dev)
+{
+    flashlog_index_t entry;
+
+    if(NULL == hlog || NULL == dev || FLASHLOG_DATA_START + FLASHLOG_BLOCK_SIZE > dev->size)
+    {
+        return HAL_ERROR;
+    }
+    hlog->dev = dev;
+    hlog->queue_head = 0;
+    hlog->queue_tail = 0;
+    hlog->dropped_count = 0;
+    flashlog_set_empty(hlog);
+
+    //newest index sector has the highest sequence number in its first entry
+    uint32_t best_sector = FLASHLOG_NO_ADDR;
+    uint32_t best_seq = 0;
+    for(uint32_t sector = 0; sector < FLASHLOG_INDEX_SIZE; sector += FLASHLOG_SECTOR_SIZE)
+    {
+        if(HAL_OK != flashlog_read_index(hlog, sector, &entry))
+        {
+            return HAL_ERROR;
+        }
+        if(flashlog_index_valid(&entry) && (FLASHLOG_NO_ADDR == best_sector || entry.seq > best_seq))
+        {
+            best_sector = sector;
+            best_seq = entry.seq;
+        }
+    }
+    if(FLASHLOG_NO_ADDR == best_sector)
+    {
+        return HAL_OK;
+    }
+
+    //entries of a sector are written in sequence, binary search for the last one
+    uint32_t lo = 0;
+    uint32_t hi = FLASHLOG_SECTOR_SIZE / FLASHLOG_ENTRY_SIZE;
+    while(1 < hi - lo)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        flashlog_read_index(hlog, best_sector + mid * FLASHLOG_ENTRY_SIZE, &entry);
+        if(flashlog_index_valid(&entry) && best_seq + mid == entry.seq)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    uint32_t last_addr = best_sector + lo * FLASHLOG_ENTRY_SIZE;
+    flashlog_read_index(hlog, last_addr, &entry);
+
+    hlog->index_addr = (last_addr + FLASHLOG_ENTRY_SIZE) % FLASHLOG_INDEX_SIZE;
+    hlog->index_seq = entry.seq + 1;
+    if(0 != hlog->index_addr % FLASHLOG_SECTOR_SIZE)
+    {
+        hlog->index_erased_addr = hlog->index_addr & ~(FLASHLOG_SECTOR_SIZE - 1U);
+    }
+
+    //an interrupted firing is treated as ended, the next start gets a new id
+    hlog->firing_id = entry.firing_id;
+    hlog->start_addr = entry.start_addr;
+    hlog->write_addr = flashlog_recover_write_addr(hlog, &entry);
+    if(0 != hlog->write_addr % FLASHLOG_BLOCK_SIZE)
+    {
+        hlog->block_erased_addr = hlog->write_addr & ~(FLASHLOG_BLOCK_SIZE - 1U);
+        hlog->mark_addr = hlog->block_erased_addr;
+    }
+    return HAL_OK;
+}
+
+/*
+ * erases the index block, blocks until done. All logged firings are lost
+ */
+HAL_StatusTypeDef flashlog_format(Flashlog_HandleTypeDef_t* hlog)
+{
+    const flashlog_device_t* dev = hlog->dev;
+    for(uint32_t sector = 0; sector < FLASHLOG_INDEX_SIZE; sector += FLASHLOG_SECTOR_SIZE)
+    {
+        while(dev->is_busy(dev->ctx));
+        if(HAL_OK != dev->erase(dev->ctx, sector, FLASHLOG_SECTOR_SIZE))
+        {
+            return HAL_ERROR;
+        }
+    }
+    while(dev->is_busy(dev->ctx));
+    hlog->queue_head = hlog->queue_tail;
+    flashlog_set_empty(hlog);
+    return HAL_OK;
+}
+
+/*
+ * puts a record in the queue, safe to call from interrupts.
+ * HAL_BUSY if the queue is full, the record is dropped then
+ */
+HAL_StatusTypeDef flashlog_append(Flashlog_HandleTypeDef_t* hlog, flashlog_record_t* record)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+    FLASHLOG_LOCK();
+    uint8_t next = (hlog->queue_head + 1) % FLASHLOG_QUEUE_LENGTH;
+    if(next == hlog->queue_tail)
+    {
+        hlog->dropped_count++;
+        status = HAL_BUSY;
+    }
+    else
+    {
+        hlog->queue[hlog->queue_head] = *record;
+        hlog->queue_head = next;
+    }
+    FLASHLOG_UNLOCK();
+    return status;
+}
+
+/*
+ * queues start of a new firing
+ */
+HAL_StatusTypeDef flashlog_start_firing(Flashlog_HandleTypeDef_t* hlog)
+{
+    flashlog_record_t record = {0};
+    record.type = FLASHLOG_REC_START;
+    return flashlog_append(hlog, &record);
+}
+
+/*
+ * queues end of the current firing
+ */
+HAL_StatusTypeDef flashlog_end_firing(Flashlog_HandleTypeDef_t* hlog)
+{
+    flashlog_record_t record = {0};
+    record.type = FLASHLOG_REC_END;
+    return flashlog_append(hlog, &record);
+}
+
+/*
+ * programs the next index entry, erases its sector first if needed.
+ * HAL_BUSY if an erase was started and the call has to be repeated
+ */
+static HAL_StatusTypeDef flashlog_write_index(Flashlog_HandleTypeDef_t* hlog, flashlog_index_type_t type, uint32_t addr)
+{
+    const flashlog_device_t* dev = hlog->dev;
+    if(0 == hlog->index_addr % FLASHLOG_SECTOR_SIZE && hlog->index_erased_addr != hlog->index_addr)
+    {
+        if(HAL_OK != dev->erase(dev->ctx, hlog->index_addr, FLASHLOG_SECTOR_SIZE))
+        {
+            return HAL_ERROR;
+        }
+        hlog->index_erased_addr = hlog->index_addr;
+        return HAL_BUSY;
+    }
+
+    flashlog_index_t entry;
+    entry.seq = hlog->index_seq;
+    entry.type = type;
+    entry.firing_id = hlog->firing_id;
+    entry.addr = addr;
+    entry.start_addr = hlog->start_addr;
+    entry.check = flashlog_index_check(&entry);
+    if(HAL_OK != dev->program(dev->ctx, hlog->index_addr, (uint8_t*)&entry, sizeof(entry)))
+    {
+        return HAL_ERROR;
+    }
+    hlog->index_seq++;
+    hlog->index_addr = (hlog->index_addr + FLASHLOG_ENTRY_SIZE) % FLASHLOG_INDEX_SIZE;
+    return HAL_OK;
+}
+
+/*
+ * writes a data record, marks and erases the next block first when one is entered.
+ * HAL_BUSY if a mark or erase was started and the call has to be repeated
+ */
+static HAL_StatusTypeDef flashlog_write_record(Flashlog_HandleTypeDef_t* hlog, flashlog_record_t* record)
+{
+    const flashlog_device_t* dev = hlog->dev;
+    uint32_t addr = hlog->write_addr;
+
+    if(0 == addr % FLASHLOG_BLOCK_SIZE && hlog->block_erased_addr != addr)
+    {
+        //mark first so the recovery finds the block even if the erase is interrupted
+        if(hlog->mark_addr != addr)
+        {
+            HAL_StatusTypeDef status = flashlog_write_index(hlog, FLASHLOG_INDEX_MARK, addr);
+            if(HAL_OK != status)
+            {
+                return status;
+            }
+            hlog->mark_addr = addr;
+            return HAL_BUSY;
+        }
+        if(HAL_OK != dev->erase(dev->ctx, addr, FLASHLOG_BLOCK_SIZE))
+        {
+            return HAL_ERROR;
+        }
+        hlog->block_erased_addr = addr;
+        return HAL_BUSY;
+    }
+
+    record->firing_id = hlog->firing_id;
+    if(HAL_OK != dev->program(dev->ctx, addr, (uint8_t*)record, sizeof(flashlog_record_t)))
+    {
+        return HAL_ERROR;
+    }
+    hlog->write_addr = flashlog_next_data_addr(hlog, addr);
+    return HAL_OK;
+}
+
+/*
+ * does at most one flash operation for the oldest queued record, call from main loop.
+ * HAL_BUSY while the device is busy or the record needs further operations
+ */
+HAL_StatusTypeDef flashlog_process(Flashlog_HandleTypeDef_t* hlog)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+    const flashlog_device_t* dev = hlog->dev;
+
+    if(hlog->queue_tail == hlog->queue_head)
+    {
+        return HAL_OK;
+    }
+    if(dev->is_busy(dev->ctx))
+    {
+        return HAL_BUSY;
+    }
+
+    flashlog_record_t* record = &hlog->queue[hlog->queue_tail];
+    switch (record->type) {
+        case FLASHLOG_REC_START:
+            if(!hlog->firing_active)
+            {
+                hlog->firing_id++;
+                if(FLASHLOG_ERASED_ID == hlog->firing_id)
+                {
+                    hlog->firing_id = 0;
+                }
+                hlog->start_addr = hlog->write_addr;
+                hlog->firing_active = 1;
+            }
+            status = flashlog_write_index(hlog, FLASHLOG_INDEX_START, hlog->write_addr);
+            break;
+        case FLASHLOG_REC_END:
+            if(hlog->firing_active)
+            {
+                status = flashlog_write_index(hlog, FLASHLOG_INDEX_END, hlog->write_addr);
+                if(HAL_OK == status)
+                {
+                    hlog->firing_active = 0;
+                }
+            }
+            break;
+        default:
+            //records outside of a firing are dropped
+            if(hlog->firing_active)
+            {
+                status = flashlog_write_record(hlog, record);
+            }
+            break;
+    }
+
+    if(HAL_BUSY != status)
+    {
+        hlog->queue_tail = (hlog->queue_tail + 1) % FLASHLOG_QUEUE_LENGTH;
+    }
+    return status;
+}
+
+/*
+ * returns 1 if all queued records are written and the device is idle
+ */
+uint8_t flashlog_is_idle(Flashlog_HandleTypeDef_t* hlog)
+{
+    return (hlog->queue_tail == hlog->queue_head && !hlog->dev->is_busy(hlog->dev->ctx));
+}
+
+/*
+ * streams all raw records of the current / last firing to write, blocking
+ */
+HAL_StatusTypeDef flashlog_dump(Flashlog_HandleTypeDef_t* hlog, flashlog_write_fn_t write)
+{
+    flashlog_record_t record;
+    const flashlog_device_t* dev = hlog->dev;
+
+    for(uint32_t addr = hlog->start_addr; addr != hlog->write_addr; addr = flashlog_next_data_addr(hlog, addr))
+    {
+        while(dev->is_busy(dev->ctx));
+        if(HAL_OK != flashlog_read_record(hlog, addr, &record))
+        {
+            return HAL_ERROR;
+        }
+        //skips blocks left behind by an interrupted erase
+        if(hlog->firing_id == record.firing_id)
+        {
+            write((uint8_t*)&record, sizeof(record));
+        }
+    }
+    return HAL_OK;
+}
@@ -0,0 +1,108 @@
+/*
+ * flashlog_file.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ *
+ *      file backed stand-in for the log flash, only built on a host with
+ *      FLASHLOG_HOST defined. Behaves like NOR: program can only clear bits,
+ *      erase sets a region back to 0xFF. Operations finish immediately.
+ */
+
+#ifdef FLASHLOG_HOST
+
+#include "flashlog.h"
+#include <stdio.h>
+#include <string.h>
+
+static HAL_StatusTypeDef flashlog_file_read(void* ctx, uint32_t addr, uint8_t* data, uint16_t len)
+{
+    FILE* file = (FILE*)ctx;
+    if(0 != fseek(file, addr, SEEK_SET) || len != fread(data, 1, len, file))
+    {
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef flashlog_file_program(void* ctx, uint32_t addr, const uint8_t* data, uint16_t len)
+{
+    uint8_t page[FLASHLOG_PAGE_SIZE];
+    FILE* file = (FILE*)ctx;
+
+    if((addr % FLASHLOG_PAGE_SIZE) + len > FLASHLOG_PAGE_SIZE
+            || HAL_OK != flashlog_file_read(ctx, addr, page, len))
+    {
+        return HAL_ERROR;
+    }
+    for(uint16_t i = 0; i < len; i++)
+    {
+        page[i] &= data[i];
+    }
+    if(0 != fseek(file, addr, SEEK_SET) || len != fwrite(page, 1, len, file))
+    {
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef flashlog_file_erase(void* ctx, uint32_t addr, uint32_t len)
+{
+    uint8_t page[FLASHLOG_PAGE_SIZE];
+    FILE* file = (FILE*)ctx;
+
+    if(0 != addr % len || 0 != fseek(file, addr, SEEK_SET))
+    {
+        return HAL_ERROR;
+    }
+    memset(page, 0xFF, sizeof(page));
+    for(uint32_t i = 0; i < len; i += sizeof(page))
+    {
+        if(sizeof(page) != fwrite(page, 1, sizeof(page), file))
+        {
+            return HAL_ERROR;
+        }
+    }
+    return HAL_OK;
+}
+
+static uint8_t flashlog_file_is_busy(void* ctx)
+{
+    (void)ctx;
+    return 0;
+}
+
+/*
+ * opens or creates image file of size bytes, a new image is fully erased
+ */
+HAL_StatusTypeDef flashlog_file_open(flashlog_device_t* dev, const char* path, uint32_t size)
+{
+    FILE* file = fopen(path, "r+b");
+    if(NULL == file)
+    {
+        file = fopen(path, "w+b");
+        if(NULL == file)
+        {
+            return HAL_ERROR;
+        }
+        for(uint32_t addr = 0; addr < size; addr += FLASHLOG_BLOCK_SIZE)
+        {
+            flashlog_file_erase(file, addr, FLASHLOG_BLOCK_SIZE);
+        }
+    }
+    dev->ctx = file;
+    dev->size = size;
+    dev->read = flashlog_file_read;
+    dev->program = flashlog_file_program;
+    dev->erase = flashlog_file_erase;
+    dev->is_busy = flashlog_file_is_busy;
+    return HAL_OK;
+}
+
+void flashlog_file_close(flashlog_device_t* dev)
+{
+    fclose((FILE*)dev->ctx);
+    dev->ctx = NULL;
+}
+
+#endif
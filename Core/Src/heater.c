@@ -7,6 +7,8 @@
 
 #include "heater.h"
 
+#define LOG_CHANNEL LOG_CH_HEATER
+
 /*
  * resets all params but the coils pin/ports to default state
  * door  open
@@ -52,65 +54,242 @@ HAL_StatusTypeDef initHeater(Heater_HandleTypeDef_t* hheater,MAX31855_HandleType
     hheater->coils.coil3.port = coil3_port;
     hheater->coils.coil3.pin = coil3_pin;
 
+    hheater->coils.coil1.output_mask = coil1_pin;
+    hheater->coils.coil2.output_mask = coil2_pin;
+    hheater->coils.coil3.output_mask = coil3_pin;
+
     heater_set_default_params(hheater);
 
     hheater->htemp = htemp;
-    hheater->time_counter = 0;
+    hheater->hpid = NULL;
+    hheater->hsched = NULL;
+    hheater->hsim = NULL;
+    hheater->control_enabled = 0;
+    hheater->pid_level = 0;
+    hheater->demand_offset = 0;
+    hheater->feedforward = 0;
+    hheater->setpoint = 0;
+    hheater->last_temperature = 0;
+    hheater->slope = 0;
+    hheater->mean = 0;
+    hheater->window_interval = PID_CALC_INTERVAL_SECONDS;
+    hheater->window_count = 0;
+    hheater->balanced = 0;
+    hheater->phase_imbalance = 0;
+    hheater->cycle_time = PWM_ON_SECONDS;
+    hheater->cycle_pending = PWM_ON_SECONDS;
+
+    return heater_set_intervals(hheater, TEMPERATURE_SAMPLING_INTERVAL_SECONDS,
+            PID_CALC_INTERVAL_SECONDS, LOG_INTERVAL_SECONDS);
+
+}
+
+/*
+ * least squares denominator sum((x_i - mean_x)^2) for n samples taken every dt seconds
+ */
+static float32_t heater_slope_denominator(uint8_t n, uint8_t dt)
+{
+    return (float32_t)dt * dt * n * ((float32_t)n * n - 1.0f) / 12.0f;
+}
 
+/*
+ * attaches pid controller and rate scheduler, both may be NULL.
+ * applies the scheduler rates right away
+ */
+HAL_StatusTypeDef heater_init_control(Heater_HandleTypeDef_t* hheater, PID_HandletypeDef_t* hpid, Scheduler_HandleTypeDef_t* hsched)
+{
+    if(NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    hheater->hpid = hpid;
+    hheater->hsched = hsched;
+
+    if(NULL != hpid)
+    {
+        PID_SetOutputLimits(hpid, 0, HEATER_MAX_LEVEL);
+    }
+    if(NULL != hsched)
+    {
+        scheduler_rates_t rates = scheduler_get_rates(hsched);
+        return heater_set_intervals(hheater, rates.sampling_interval, rates.pid_interval, rates.log_interval);
+    }
+    if(NULL != hpid)
+    {
+        PID_SetSampleTime(hpid, hheater->pid_interval);
+    }
     return HAL_OK;
+}
 
+/*
+ * sets reference for the attached pid and enables closed loop control.
+ * Can be called at any time, the pid keeps its state so changes are bumpless
+ */
+HAL_StatusTypeDef heater_set_setpoint(Heater_HandleTypeDef_t* hheater, float32_t setpoint)
+{
+    if(NULL == hheater || NULL == hheater->hpid)
+    {
+        return HAL_ERROR;
+    }
+    hheater->setpoint = setpoint;
+    hheater->control_enabled = 1;
+    return HAL_OK;
 }
 
+/*
+ * disables closed loop control and turns all coils off
+ */
+HAL_StatusTypeDef heater_disable_control(Heater_HandleTypeDef_t* hheater)
+{
+    if(NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    hheater->control_enabled = 0;
+    hheater->pid_level = 0;
+    hheater->demand_offset = 0;
+    hheater->feedforward = 0;
+    return heater_set_level(hheater, 0);
+}
 
 /*
- * LL set coil On
+ * applies pid level plus demand offset limited to valid levels
  */
-static void heater_set_coil_on(heater_coil_t* coil)
+static HAL_StatusTypeDef heater_apply_demand(Heater_HandleTypeDef_t* hheater)
 {
-    HAL_GPIO_WritePin(coil->port, coil->pin, GPIO_PIN_SET);
+    int16_t level = (int16_t)hheater->pid_level + hheater->demand_offset;
+    if(0 > level)
+    {
+        level = 0;
+    }
+    if(HEATER_MAX_LEVEL < level)
+    {
+        level = HEATER_MAX_LEVEL;
+    }
+    if(HAL_OK != heater_set_level(hheater, (uint8_t)level))
+    {
+        return HAL_ERROR;
+    }
+    return heater_set_state(hheater);
+}
+
+/*
+ * sets an offset in levels that is added to the pid demand, applied immediately
+ */
+HAL_StatusTypeDef heater_set_demand_offset(Heater_HandleTypeDef_t* hheater, int8_t offset)
+{
+    if(NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    hheater->demand_offset = offset;
+    if(!hheater->control_enabled)
+    {
+        return HAL_OK;
+    }
+    return heater_apply_demand(hheater);
+}
+
+/*
+ * sets feed forward in levels, added to the pid output from the next pid window on
+ */
+HAL_StatusTypeDef heater_set_feedforward(Heater_HandleTypeDef_t* hheater, float32_t feedforward)
+{
+    if(NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    hheater->feedforward = feedforward;
+    return HAL_OK;
+}
+
+/*
+ * sets sampling, pid and log interval in seconds and recomputes the slope filter
+ * and the pid gains for the new rate. Restarts the current measurement window.
+ */
+HAL_StatusTypeDef heater_set_intervals(Heater_HandleTypeDef_t* hheater, uint8_t sampling_interval, uint8_t pid_interval, uint8_t log_interval)
+{
+    if(NULL == hheater || 0 == sampling_interval || 0 == log_interval)
+    {
+        return HAL_ERROR;
+    }
+    uint8_t n = pid_interval / sampling_interval;
+    if(2 > n || MAX_MEAS_AR_LENGTH < n)
+    {
+        return HAL_ERROR;
+    }
+
+    hheater->sampling_interval = sampling_interval;
+    hheater->pid_interval = pid_interval;
+    hheater->log_interval = log_interval;
+    hheater->slope_denominator = heater_slope_denominator(n, sampling_interval);
+
+    if(NULL != hheater->hpid)
+    {
+        PID_SetSampleTime(hheater->hpid, pid_interval);
+    }
+
+    hheater->time_counter = 0;
+    hheater->log_counter = 0;
+    hheater->sample_count = 0;
+    return HAL_OK;
+}
+
+
+/*
+ * LL set coil On, writes BSRR directly so it runs from RAM without a HAL call.
+ * Pins not in the output mask are never set
+ */
+RAMFUNC static void heater_set_coil_on(heater_coil_t* coil)
+{
+    coil->port->BSRR = (uint32_t)(coil->pin & coil->output_mask);
 
 }
 
 /*
  * LL set coil Off
  */
-static void heater_set_coil_off(heater_coil_t* coil)
+RAMFUNC static void heater_set_coil_off(heater_coil_t* coil)
 {
-    HAL_GPIO_WritePin(coil->port, coil->pin, GPIO_PIN_RESET);
+    coil->port->BRR = (uint32_t)coil->pin;
 }
 
 /*
  * LL toggle coil
  */
-static void heater_toggle_coil(heater_coil_t* coil)
+RAMFUNC static void heater_toggle_coil(heater_coil_t* coil)
 {
-    HAL_GPIO_TogglePin(coil->port, coil->pin);
+    uint32_t odr = coil->port->ODR;
+    coil->port->BSRR = ((odr & coil->pin) << 16U) | (~odr & coil->pin & coil->output_mask);
 }
 /*
- * pwm control of a coil
+ * pwm control of a coil, on and off for cycle_time seconds each. Returns 1 on a switching edge
  */
-static void heater_update_pwm_coil(heater_coil_t* coil)
+RAMFUNC static uint8_t heater_update_pwm_coil(heater_coil_t* coil, uint8_t cycle_time)
 {
     //coil wasnt in pwm mode allready, set last tick
     if(0 == coil->time_pwm_last){
-        coil->time_pwm_last = HAL_GetTick();
+        coil->time_pwm_last = uwTick;
     }
     //coil was in pwm mode allready, toggle
     else{
-        uint32_t time = HAL_GetTick();
-        if(time >= (PWM_ON_SECONDS + coil->time_pwm_last))
+        //uwTick instead of HAL_GetTick, which is in flash
+        uint32_t time = uwTick;
+        if(time >= (cycle_time * 1000U + coil->time_pwm_last))
         {
             coil->time_pwm_last = time;
             heater_toggle_coil(coil);
+            return 1;
         }
     }
+    return 0;
 }
 
 /*
  * sets state of individual heater coil according to params stored in instance
  */
 //TODO Implement using RTC because uint32_t will overflow at some point
-static HAL_StatusTypeDef heater_set_coil_state(heater_coil_t* coil)
+RAMFUNC static HAL_StatusTypeDef heater_set_coil_state(heater_coil_t* coil, uint8_t cycle_time, uint8_t* edge)
 {
     if(NULL == coil)
     {
@@ -126,7 +305,7 @@ static HAL_StatusTypeDef heater_set_coil_state(heater_coil_t* coil)
             heater_set_coil_on(coil);
             break;
         case COIL_PWM:
-            heater_update_pwm_coil(coil);
+            *edge |= heater_update_pwm_coil(coil, cycle_time);
             break;
         default:
             return HAL_ERROR;
@@ -135,6 +314,186 @@ static HAL_StatusTypeDef heater_set_coil_state(heater_coil_t* coil)
     return HAL_OK;
 }
 
+/*
+ * sets supply phase of each coil and enables the balanced allocation
+ */
+HAL_StatusTypeDef heater_set_phases(Heater_HandleTypeDef_t* hheater, uint8_t coil1_phase, uint8_t coil2_phase, uint8_t coil3_phase)
+{
+    if(NULL == hheater || HEATER_PHASES <= coil1_phase || HEATER_PHASES <= coil2_phase || HEATER_PHASES <= coil3_phase)
+    {
+        return HAL_ERROR;
+    }
+    hheater->coils.coil1.phase = coil1_phase;
+    hheater->coils.coil2.phase = coil2_phase;
+    hheater->coils.coil3.phase = coil3_phase;
+    for(uint8_t i = 0; i < HEATER_PHASES; i++)
+    {
+        hheater->phase_on[i] = 0;
+        hheater->window_on[i] = 0;
+    }
+    hheater->slot_remaining = 0;
+    hheater->credit = 0;
+    hheater->rotation = 0;
+    hheater->phase_imbalance = 0;
+    hheater->balanced = 1;
+    return heater_set_level(hheater, hheater->heater_level);
+}
+
+/*
+ * starts a slot: turns on as many whole coils as the level demands including the
+ * remainder of earlier slots, on the phases with the least on time.
+ * Phase on times are kept relative to the least loaded phase
+ */
+static void heater_allocate_slot(Heater_HandleTypeDef_t* hheater)
+{
+    heater_coil_t* coils[] = {&hheater->coils.coil1, &hheater->coils.coil2, &hheater->coils.coil3};
+    uint32_t load[HEATER_PHASES];
+
+    hheater->cycle_time = hheater->cycle_pending;
+    hheater->slot_remaining = hheater->cycle_time;
+    hheater->credit = (0 == hheater->heater_level) ? 0 : hheater->credit + hheater->heater_level;
+    uint8_t count = hheater->credit / 2;
+    if(3 < count)
+    {
+        count = 3;
+    }
+    hheater->credit -= 2 * count;
+
+    uint32_t least = UINT32_MAX;
+    for(uint8_t i = 0; i < 3; i++)
+    {
+        coils[i]->state = COIL_OFF;
+        if(hheater->phase_on[coils[i]->phase] < least)
+        {
+            least = hheater->phase_on[coils[i]->phase];
+        }
+    }
+    for(uint8_t i = 0; i < HEATER_PHASES; i++)
+    {
+        hheater->phase_on[i] = (hheater->phase_on[i] > least) ? hheater->phase_on[i] - least : 0;
+        load[i] = hheater->phase_on[i];
+    }
+
+    for(uint8_t n = 0; n < count; n++)
+    {
+        heater_coil_t* best = NULL;
+        for(uint8_t i = 0; i < 3; i++)
+        {
+            heater_coil_t* coil = coils[(hheater->rotation + i) % 3];
+            if(COIL_OFF == coil->state && (NULL == best || load[coil->phase] < load[best->phase]))
+            {
+                best = coil;
+            }
+        }
+        best->state = COIL_ON;
+        load[best->phase] += hheater->cycle_time;
+    }
+    hheater->rotation = (hheater->rotation + 1) % 3;
+}
+
+/*
+ * adds one tick of on time to the phases of all coils that are on
+ */
+static void heater_count_phases(Heater_HandleTypeDef_t* hheater)
+{
+    heater_coil_t* coils[] = {&hheater->coils.coil1, &hheater->coils.coil2, &hheater->coils.coil3};
+    for(uint8_t i = 0; i < 3; i++)
+    {
+        if(COIL_ON == coils[i]->state)
+        {
+            hheater->phase_on[coils[i]->phase] += INTERUPT_INTERVAL_SECONDS;
+            hheater->window_on[coils[i]->phase] += INTERUPT_INTERVAL_SECONDS;
+        }
+    }
+    if(0 != hheater->slot_remaining)
+    {
+        hheater->slot_remaining--;
+    }
+}
+
+/*
+ * spread of phase on time over the finished pid window, restarts the window
+ */
+static void heater_update_imbalance(Heater_HandleTypeDef_t* hheater)
+{
+    heater_coil_t* coils[] = {&hheater->coils.coil1, &hheater->coils.coil2, &hheater->coils.coil3};
+    uint16_t max = 0;
+    uint16_t min = UINT16_MAX;
+    for(uint8_t i = 0; i < 3; i++)
+    {
+        uint16_t on = hheater->window_on[coils[i]->phase];
+        max = (on > max) ? on : max;
+        min = (on < min) ? on : min;
+    }
+    hheater->phase_imbalance = (uint8_t)((max - min) * 100U / hheater->pid_interval);
+    for(uint8_t i = 0; i < HEATER_PHASES; i++)
+    {
+        hheater->window_on[i] = 0;
+    }
+}
+
+/*
+ * attaches a kiln model, NULL detaches it. While attached the coil outputs are masked
+ * and held off, the model is stepped with the heater level and sampled instead of the thermocouple
+ */
+HAL_StatusTypeDef heater_set_simulation(Heater_HandleTypeDef_t* hheater, Sim_HandleTypeDef_t* hsim)
+{
+    if(NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    heater_coil_t* coils[] = {&hheater->coils.coil1, &hheater->coils.coil2, &hheater->coils.coil3};
+    for(uint8_t i = 0; i < 3; i++)
+    {
+        coils[i]->output_mask = (NULL == hsim) ? coils[i]->pin : 0;
+        heater_set_coil_off(coils[i]);
+        coils[i]->time_pwm_last = 0;
+    }
+    hheater->hsim = hsim;
+    return HAL_OK;
+}
+
+/*
+ * sets on and off time of a pwm coil and the slot of the balanced allocation [s].
+ * Takes effect at the next switching edge or slot so the output stays bumpless
+ */
+HAL_StatusTypeDef heater_set_cycle_time(Heater_HandleTypeDef_t* hheater, uint8_t cycle_time)
+{
+    if(NULL == hheater || HEATER_MIN_CYCLE_SECONDS > cycle_time || HEATER_MAX_CYCLE_SECONDS < cycle_time)
+    {
+        return HAL_ERROR;
+    }
+    hheater->cycle_pending = cycle_time;
+    return HAL_OK;
+}
+
+/*
+ * bit per coil whose output is driven. Coils that are on count as well so the
+ * outputs can be followed while simulating
+ */
+uint8_t heater_get_outputs(Heater_HandleTypeDef_t* hheater)
+{
+    heater_coil_t* coils[] = {&hheater->coils.coil1, &hheater->coils.coil2, &hheater->coils.coil3};
+    uint8_t outputs = 0;
+    for(uint8_t i = 0; i < 3; i++)
+    {
+        if((coils[i]->port->ODR & coils[i]->pin) || COIL_ON == coils[i]->state)
+        {
+            outputs |= 1U << i;
+        }
+    }
+    return outputs;
+}
+
+/*
+ * number of coil outputs that switched between two heater_get_outputs
+ */
+uint8_t heater_count_switches(uint8_t previous, uint8_t outputs)
+{
+    uint8_t changed = previous ^ outputs;
+    return (changed & 1U) + ((changed >> 1) & 1U) + ((changed >> 2) & 1U);
+}
+
 /*
  * checks if door flag was set and turns heater of
  */
@@ -198,12 +557,26 @@ HAL_StatusTypeDef heater_turn_off(Heater_HandleTypeDef_t* hheater)
 }
 
 /*
- * HL set the heater level from 1-6
+ * HL set the heater level from 1-6. With balanced allocation the coils are chosen
+ * at the start of the next slot, the running slot is finished so it is not cut short.
+ * Turning off or on from 0 starts a new slot with the next set state
  */
 HAL_StatusTypeDef heater_set_level(Heater_HandleTypeDef_t* hheater, uint8_t level)
 {
-
+    if(HEATER_MAX_LEVEL < level)
+    {
+        return HAL_ERROR;
+    }
+    uint8_t previous = hheater->heater_level;
     hheater->heater_level = level;
+    if(hheater->balanced)
+    {
+        if(0 == level || 0 == previous)
+        {
+            hheater->slot_remaining = 0;
+        }
+        return HAL_OK;
+    }
 
 
     switch (level) {
@@ -259,34 +632,54 @@ HAL_StatusTypeDef heater_set_state(Heater_HandleTypeDef_t* hheater)
     {
         return HAL_ERROR;
     }
+    if(hheater->balanced && 0 == hheater->slot_remaining)
+    {
+        heater_allocate_slot(hheater);
+    }
 
-    heater_set_coil_state(&hheater->coils.coil1);
-    heater_set_coil_state(&hheater->coils.coil2);
-    heater_set_coil_state(&hheater->coils.coil3);
+    //a new cycle time takes effect at a switching edge, the running on or off time is kept
+    uint8_t edge = (0 == hheater->coils.coil1.time_pwm_last && 0 == hheater->coils.coil2.time_pwm_last
+            && 0 == hheater->coils.coil3.time_pwm_last);
+    heater_set_coil_state(&hheater->coils.coil1, hheater->cycle_time, &edge);
+    heater_set_coil_state(&hheater->coils.coil2, hheater->cycle_time, &edge);
+    heater_set_coil_state(&hheater->coils.coil3, hheater->cycle_time, &edge);
+    if(edge && !hheater->balanced)
+    {
+        hheater->cycle_time = hheater->cycle_pending;
+    }
 
     return HAL_OK;
 }
 /*
  * calculates slope from temperature array of Heater_HandleTypeDef struct
  */
-float32_t heater_calculate_slope(Heater_HandleTypeDef_t* hheater) {
+RAMFUNC float32_t heater_calculate_slope(Heater_HandleTypeDef_t* hheater) {
 
     float32_t* temp = hheater->temperature;
     float32_t mean_temp = 0;
     //float32_t covariance = 0;
     //float32_t variance_time = 0;
     //float32_t variance_temp = 0;
-    uint32_t total_intervals = PID_CALC_INTERVAL_SECONDS / TEMPERATURE_SAMPLING_INTERVAL_SECONDS;
-    float32_t mean_time = ((total_intervals + 1.0f) * TEMPERATURE_SAMPLING_INTERVAL_SECONDS) / 2.0f;
+    uint8_t total_intervals = hheater->sample_count;
+    uint8_t dt = hheater->sampling_interval;
+    if (2 > total_intervals) {
+        return 0;
+    }
+    float32_t mean_time = ((total_intervals - 1.0f) * dt) / 2.0f;
 
     arm_mean_f32(temp, total_intervals, &mean_temp);
-    // Calculate the numerator and denominator of the gradient formula
+    // Calculate the numerator of the gradient formula, denominator only changes with the rate.
+    // The time offset is stepped in float, an int to float conversion per sample runs from flash
     float32_t numerator = 0;
-    float32_t denominator = 0;
+    float32_t time_offset = -mean_time;
+    float32_t step = dt;
     for (uint32_t i = 0; i < total_intervals; i++) {
-        numerator += (i * TEMPERATURE_SAMPLING_INTERVAL_SECONDS - mean_time) * (temp[i] - mean_temp);
-        denominator += (i * TEMPERATURE_SAMPLING_INTERVAL_SECONDS - mean_time)
-                * (i * TEMPERATURE_SAMPLING_INTERVAL_SECONDS - mean_time);
+        numerator += time_offset * (temp[i] - mean_temp);
+        time_offset += step;
+    }
+    float32_t denominator = hheater->slope_denominator;
+    if (total_intervals != hheater->pid_interval / dt) {
+        denominator = heater_slope_denominator(total_intervals, dt);
     }
     float32_t slope = numerator / denominator;
 //    //variance of time
@@ -312,12 +705,15 @@ float32_t heater_calculate_slope(Heater_HandleTypeDef_t* hheater) {
 /*
  * calculates slope from temperature array of Heater_HandleTypeDef struct
  */
-float32_t heater_calculate_mean(Heater_HandleTypeDef_t* hheater) {
+RAMFUNC float32_t heater_calculate_mean(Heater_HandleTypeDef_t* hheater) {
 
     float32_t* temp = hheater->temperature;
     float32_t mean_temp = 0;
 
-    uint32_t total_intervals = PID_CALC_INTERVAL_SECONDS / TEMPERATURE_SAMPLING_INTERVAL_SECONDS;
+    uint32_t total_intervals = hheater->sample_count;
+    if (0 == total_intervals) {
+        return 0;
+    }
 
     arm_mean_f32(temp, total_intervals, &mean_temp);
 
@@ -329,11 +725,11 @@ float32_t heater_calculate_mean(Heater_HandleTypeDef_t* hheater) {
 void heater_set_temperature_zero(Heater_HandleTypeDef_t* hheater)
 {
 
-    uint8_t length = PID_CALC_INTERVAL_SECONDS / INTERUPT_INTERVAL_SECONDS;
-    for(uint8_t i = 0; i < length; i++)
+    for(uint8_t i = 0; i < MAX_MEAS_AR_LENGTH; i++)
     {
         hheater->temperature[i] = 0;
     }
+    hheater->sample_count = 0;
 }
 
 void heater_print_test(RTC_HandleTypeDef *hrtc, float32_t temperature)
@@ -344,31 +740,91 @@ void heater_print_test(RTC_HandleTypeDef *hrtc, float32_t temperature)
     HAL_RTC_GetTime(hrtc, &sTime, RTC_FORMAT_BIN);
     HAL_RTC_GetDate(hrtc, &sDate, RTC_FORMAT_BIN);
 
-    printf("%02d:%02d:%02d,%.2f\r\n", sTime.Hours, sTime.Minutes, sTime.Seconds,temperature);
+    LOG_MSG(LOG_INFO, "%02d:%02d:%02d,%.2f", sTime.Hours, sTime.Minutes, sTime.Seconds,temperature);
 
 }
 void heater_on_interupt(Heater_HandleTypeDef_t* hheater,RTC_HandleTypeDef *hrtc)
 {
+    //keep pwm and door state up to date every tick
+    heater_set_state(hheater);
+    if(hheater->balanced)
+    {
+        heater_count_phases(hheater);
+    }
+    if(NULL != hheater->hsim)
+    {
+        sim_step(hheater->hsim, hheater->heater_level);
+    }
+
     hheater->time_counter++;
     //printf("counter: %u \r\n", hheater->time_counter);
     //check if interval for sampling temperature has passed
-    if(TEMPERATURE_SAMPLING_INTERVAL_SECONDS / INTERUPT_INTERVAL_SECONDS  <= hheater->time_counter)
+    if(0 == hheater->time_counter % hheater->sampling_interval && MAX_MEAS_AR_LENGTH > hheater->sample_count)
         {
-            max31855_read_data(hheater->htemp);
-            hheater->temperature[hheater->time_counter - 1] = max31855_get_temp_f32(hheater->htemp);
-            heater_print_test(hrtc,hheater->temperature[hheater->time_counter - 1]);
+            //bus is shared with the log flash, keep the last value if it is busy
+            float32_t temperature = hheater->last_temperature;
+            if(NULL != hheater->hsim)
+            {
+                temperature = sim_get_temperature(hheater->hsim);
+            }
+            else if(HAL_OK == max31855_read_data(hheater->htemp))
+            {
+                temperature = max31855_get_temp_f32(hheater->htemp);
+            }
+            hheater->temperature[hheater->sample_count++] = temperature;
+            hheater->last_temperature = temperature;
+
+            //log output runs at its own, usually slower, rate
+            hheater->log_counter += hheater->sampling_interval;
+            //the simulation logs once per real log interval, not per accelerated one
+            uint16_t log_interval = hheater->log_interval;
+            if(NULL != hheater->hsim)
+            {
+                log_interval *= hheater->hsim->acceleration;
+            }
+            if(log_interval <= hheater->log_counter)
+            {
+                hheater->log_counter = 0;
+                //skips reading the rtc when the channel is off
+                if(LOG_ENABLED(LOG_CHANNEL, LOG_INFO))
+                {
+                    heater_print_test(hrtc,temperature);
+                }
+            }
         }
     //check if intervall for pid is met
-    if(PID_CALC_INTERVAL_SECONDS / INTERUPT_INTERVAL_SECONDS  <= hheater->time_counter)
+    if(hheater->pid_interval / INTERUPT_INTERVAL_SECONDS  <= hheater->time_counter)
     {
-        //TODO
         float32_t slope = heater_calculate_slope(hheater);
         float32_t mean = heater_calculate_mean(hheater);
-        //TODO pid calculation
+        hheater->slope = slope * 3600;
+        hheater->mean = mean;
+        hheater->window_interval = hheater->pid_interval;
+        hheater->window_count++;
+        if(hheater->balanced)
+        {
+            heater_update_imbalance(hheater);
+        }
 
-        printf("slope: %f, mean: %f\r\n",slope * 3600,mean);
+        if(NULL != hheater->hpid && hheater->control_enabled)
+        {
+            //limits shifted by the feed forward, so saturation and anti windup see the applied level
+            PID_SetOutputLimits(hheater->hpid, -hheater->feedforward, HEATER_MAX_LEVEL - hheater->feedforward);
+            float32_t output = PID_Calculate(hheater->hpid, mean, hheater->setpoint) + hheater->feedforward;
+            hheater->pid_level = (uint8_t)(output + 0.5f);
+            heater_apply_demand(hheater);
+        }
+
+        LOG_MSG(LOG_DEBUG, "slope: %f, mean: %f, imbalance: %u%%",slope * 3600,mean, hheater->phase_imbalance);
         heater_set_temperature_zero(hheater);
         hheater->time_counter = 0;
+
+        //adapt rates for next window, recomputes filter and pid coefficients
+        if(NULL != hheater->hsched && scheduler_update(hheater->hsched, slope * 3600, mean))
+        {
+            scheduler_rates_t rates = scheduler_get_rates(hheater->hsched);
+            heater_set_intervals(hheater, rates.sampling_interval, rates.pid_interval, rates.log_interval);
+        }
         return;
     }
 
@@ -0,0 +1,121 @@
+/*
+ * heatwork.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "heatwork.h"
+
+//relative rate every HEATWORK_TABLE_STEP C from HEATWORK_TABLE_START, 4 at the start
+static const uint32_t heatwork_rate_table[HEATWORK_TABLE_LENGTH] =
+{
+    4U, 7U, 13U, 23U, 40U, 69U, 118U, 201U,
+    339U, 567U, 940U, 1545U, 2520U, 4079U, 6551U, 10444U,
+    16529U, 25974U, 40535U, 62831U, 96747U, 148010U, 225007U, 339947U,
+    510501U, 762097U, 1131118U, 1669336U, 2450023U, 3576335U, 5192754U, 7500620U,
+    10779120U, 15413525U, 21932977U, 31060850U, 43781569U, 61428865U, 85801856U, 119317103U,
+    165206955U, 227777255U, 312740860U, 427647617U, 582436620U, 790142885U, 1067798385U, 1437576821U,
+    1928242997U, 2576981645U, 3431697294U,
+};
+
+typedef struct
+{
+    char name[4];
+    uint16_t temperature;   //[C] Orton self supporting at 60C/h
+    uint64_t work;          //heat work of a 60C/h ramp to temperature
+}heatwork_cone_t;
+
+static const heatwork_cone_t heatwork_cone_table[HEATWORK_CONES] =
+{
+    {"010",  887, 28020ULL},
+    {"09",   915, 155400ULL},
+    {"08",   945, 818400ULL},
+    {"07",   973, 3462600ULL},
+    {"06",   991, 8418960ULL},
+    {"05",  1031, 55328700ULL},
+    {"04",  1050, 130090200ULL},
+    {"03",  1086, 615340320ULL},
+    {"02",  1101, 1147582320ULL},
+    {"01",  1117, 2201634120ULL},
+    {"1",   1136, 4678498980ULL},
+    {"2",   1142, 5908098960ULL},
+    {"3",   1152, 8688449640ULL},
+    {"4",   1168, 15941332200ULL},
+    {"5",   1177, 22286978400ULL},
+    {"6",   1222, 112149764340ULL},
+    {"7",   1239, 201642382980ULL},
+    {"8",   1249, 282943760520ULL},
+    {"9",   1260, 408598992600ULL},
+    {"10",  1285, 924456481200ULL},
+};
+
+/*
+ * interpolated rate at temperature
+ */
+static uint32_t heatwork_rate(int16_t temperature)
+{
+    if(HEATWORK_TABLE_START > temperature)
+    {
+        return 0;
+    }
+    uint16_t offset = temperature - HEATWORK_TABLE_START;
+    uint16_t index = offset / HEATWORK_TABLE_STEP;
+    if(HEATWORK_TABLE_LENGTH - 1 <= index)
+    {
+        return heatwork_rate_table[HEATWORK_TABLE_LENGTH - 1];
+    }
+    uint32_t rate = heatwork_rate_table[index];
+    return rate + (heatwork_rate_table[index + 1] - rate) / HEATWORK_TABLE_STEP * (offset % HEATWORK_TABLE_STEP);
+}
+
+void heatwork_reset(Heatwork_HandleTypeDef_t* hwork)
+{
+    hwork->work = 0;
+    hwork->cone = 0;
+}
+
+/*
+ * adds heat work of seconds at temperature [C]
+ */
+void heatwork_add(Heatwork_HandleTypeDef_t* hwork, float32_t temperature, uint8_t seconds)
+{
+    hwork->work += (uint64_t)heatwork_rate((int16_t)temperature) * seconds;
+    while(HEATWORK_CONES > hwork->cone && heatwork_cone_table[hwork->cone].work <= hwork->work)
+    {
+        hwork->cone++;
+    }
+}
+
+/*
+ * returns 1 if heat work of cone is reached, always for cone 0
+ */
+uint8_t heatwork_is_reached(const Heatwork_HandleTypeDef_t* hwork, uint8_t cone)
+{
+    return (cone <= hwork->cone);
+}
+
+/*
+ * returns heat work in percent of cone, limited to 999
+ */
+uint16_t heatwork_get_progress(const Heatwork_HandleTypeDef_t* hwork, uint8_t cone)
+{
+    if(0 == cone || HEATWORK_CONES < cone)
+    {
+        return 0;
+    }
+    uint64_t percent = hwork->work * 100U / heatwork_cone_table[cone - 1].work;
+    return (999U < percent) ? 999U : (uint16_t)percent;
+}
+
+/*
+ * returns name of cone as printed on it, "--" for 0
+ */
+const char* heatwork_cone_name(uint8_t cone)
+{
+    if(0 == cone || HEATWORK_CONES < cone)
+    {
+        return "--";
+    }
+    return heatwork_cone_table[cone - 1].name;
+}
@@ -0,0 +1,161 @@
+/*
+ * loadest.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "loadest.h"
+
+/*
+ * init function of load estimator, nominal load until the first estimate
+ */
+HAL_StatusTypeDef initLoadest(Loadest_HandleTypeDef_t* hload, Heater_HandleTypeDef_t* hheater)
+{
+    if(NULL == hload || NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    hload->hheater = hheater;
+    hload->state = LOADEST_IDLE;
+    hload->slope = LOADEST_NOMINAL_SLOPE;
+    hload->factor = 1.0f;
+    hload->load_class = LOADEST_CLASS_NOMINAL;
+    return HAL_OK;
+}
+
+/*
+ * starts measurement, turns pid control off and heats at LOADEST_LEVEL
+ */
+HAL_StatusTypeDef loadest_start(Loadest_HandleTypeDef_t* hload)
+{
+    if(NULL == hload)
+    {
+        return HAL_ERROR;
+    }
+    hload->state = LOADEST_SETTLE;
+    hload->time = 0;
+    hload->slope_sum = 0;
+    hload->slope_count = 0;
+
+    heater_disable_control(hload->hheater);
+    if(HAL_OK != heater_set_level(hload->hheater, LOADEST_LEVEL))
+    {
+        return HAL_ERROR;
+    }
+    return heater_set_state(hload->hheater);
+}
+
+/*
+ * aborts measurement, last estimate stays valid
+ */
+void loadest_stop(Loadest_HandleTypeDef_t* hload)
+{
+    if(LOADEST_DONE != hload->state)
+    {
+        hload->state = LOADEST_IDLE;
+    }
+}
+
+uint8_t loadest_is_running(Loadest_HandleTypeDef_t* hload)
+{
+    return (LOADEST_SETTLE == hload->state || LOADEST_MEASURE == hload->state);
+}
+
+/*
+ * returns feed forward gain [levels per C/h] of the estimated load
+ */
+float32_t loadest_get_feedforward_gain(Loadest_HandleTypeDef_t* hload)
+{
+    return hload->factor * LOADEST_LEVEL / LOADEST_NOMINAL_SLOPE;
+}
+
+/*
+ * derives load factor and class from the averaged slope
+ */
+static void loadest_finish(Loadest_HandleTypeDef_t* hload)
+{
+    Heater_HandleTypeDef_t* hheater = hload->hheater;
+    if(0 != hload->slope_count)
+    {
+        hload->slope = hload->slope_sum / hload->slope_count;
+    }
+    else
+    {
+        //pid windows longer than the measurement, fall back to the overall rise
+        hload->slope = (hheater->last_temperature - hload->start_temperature) * 3600.0f / LOADEST_MEASURE_SECONDS;
+    }
+
+    float32_t factor = LOADEST_MAX_FACTOR;
+    if(0 < hload->slope)
+    {
+        factor = LOADEST_NOMINAL_SLOPE / hload->slope;
+    }
+    if(LOADEST_MIN_FACTOR > factor)
+    {
+        factor = LOADEST_MIN_FACTOR;
+    }
+    if(LOADEST_MAX_FACTOR < factor)
+    {
+        factor = LOADEST_MAX_FACTOR;
+    }
+    hload->factor = factor;
+
+    hload->load_class = LOADEST_CLASS_NOMINAL;
+    if(LOADEST_LIGHT_FACTOR > factor)
+    {
+        hload->load_class = LOADEST_CLASS_LIGHT;
+    }
+    else if(LOADEST_HEAVY_FACTOR < factor)
+    {
+        hload->load_class = LOADEST_CLASS_HEAVY;
+    }
+    hload->state = LOADEST_DONE;
+}
+
+/*
+ * collects slopes of finished pid windows, returns 1 once the estimate is done
+ */
+uint8_t loadest_on_interupt(Loadest_HandleTypeDef_t* hload)
+{
+    Heater_HandleTypeDef_t* hheater = hload->hheater;
+
+    switch (hload->state) {
+        case LOADEST_SETTLE:
+            hload->time += INTERUPT_INTERVAL_SECONDS;
+            if(LOADEST_SETTLE_SECONDS <= hload->time)
+            {
+                hload->state = LOADEST_MEASURE;
+                hload->last_window = hheater->window_count;
+                hload->skip_window = 1;
+                hload->start_temperature = hheater->last_temperature;
+            }
+            return 0;
+        case LOADEST_MEASURE:
+            hload->time += INTERUPT_INTERVAL_SECONDS;
+            if(hload->last_window != hheater->window_count)
+            {
+                //first window started before the measurement and is skipped
+                if(hload->skip_window)
+                {
+                    hload->skip_window = 0;
+                }
+                else
+                {
+                    hload->slope_sum += hheater->slope;
+                    hload->slope_count++;
+                }
+                hload->last_window = hheater->window_count;
+            }
+            if(LOADEST_SETTLE_SECONDS + LOADEST_MEASURE_SECONDS <= hload->time)
+            {
+                loadest_finish(hload);
+                return 1;
+            }
+            return 0;
+        case LOADEST_DONE:
+            return 1;
+        default:
+            return 0;
+    }
+}
@@ -17,9 +17,25 @@
 #include <log.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 
 
 static UART_HandleTypeDef* hlog_huart; // Store the UART handle
+static Dmamgr_HandleTypeDef_t* hlog_dma = NULL; // NULL: logWrite blocks on the uart
+static dmamgr_transfer_t log_dma_transfers[LOG_DMA_BUFFERS];
+static uint8_t log_dma_buffers[LOG_DMA_BUFFERS][LOG_DMA_BUFFER_SIZE];
+static uint8_t log_dma_next = 0;
+
+//indexed by log_channel_t
+static const char* const log_channel_names[LOG_CH_COUNT] =
+{
+    "main", "heater", "ui", "event", "firing", "sysid", "flashlog", "shadow"
+};
+
+uint8_t log_channel_mask[LOG_CH_COUNT] =
+{
+    [0 ... LOG_CH_COUNT - 1] = LOG_MASK_FROM(LOG_DEFAULT_LEVEL)
+};
 
 /**
  * @brief initializes all needed log params
@@ -28,35 +44,168 @@ static UART_HandleTypeDef* hlog_huart; // Store the UART handle
  */
 void initLog(UART_HandleTypeDef* huart) {
     hlog_huart = huart; // Store the UART handle for later use
+    // unbuffered, stdio does not allocate a buffer from the heap
+    setvbuf(stdout, NULL, _IONBF, 0);
 }
 
 /**
- * @brief logging feature: log levels and mesage
+ * @brief logging feature: prints message, use LOG_MSG to filter by channel and level
  * @param variatic params
  * @return none
  */
 
 void logMsg(int logLevel, const char* format, ...) {
-    if (logLevel >= LOG_LEVEL_THRESHOLD) {
-        va_list args;
-        va_start(args, format);
+    (void) logLevel;
+    va_list args;
+    va_start(args, format);
+
+    char buffer[256]; // Adjust the buffer size as needed
+    vsnprintf(buffer, sizeof(buffer), format, args);
+
+    // Output log message through UART using printf
+    printf("%s", buffer);
+    printf("\r\n");
+
+    va_end(args);
+}
+
+/**
+ * @brief sets mask of enabled levels for a channel
+ * @param channel name, "all" for every channel, and mask of LOG_MASK bits
+ * @return HAL_ERROR if there is no such channel
+ */
+HAL_StatusTypeDef log_set_mask(const char* channel, uint8_t mask) {
+    HAL_StatusTypeDef status = HAL_ERROR;
+    for (uint8_t i = 0; i < LOG_CH_COUNT; i++) {
+        if (0 == strcmp(channel, "all") || 0 == strcmp(channel, log_channel_names[i])) {
+            log_channel_mask[i] = mask;
+            status = HAL_OK;
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief prints masks of all channels
+ * @return none
+ */
+void log_print_masks(void) {
+    for (uint8_t i = 0; i < LOG_CH_COUNT; i++) {
+        printf("%-9s 0x%x\r\n", log_channel_names[i], log_channel_mask[i]);
+    }
+}
+
+/**
+ * @brief sends logWrite through the dma manager with request of the log uart
+ * @param manager and its request for the uart tx
+ * @return none
+ */
+void log_attach_dma(Dmamgr_HandleTypeDef_t* hdma, dmamgr_request_t request) {
+    for (uint8_t i = 0; i < LOG_DMA_BUFFERS; i++) {
+        dmamgr_transfer_t* transfer = &log_dma_transfers[i];
+        transfer->request = request;
+        transfer->priority = DMAMGR_PRIO_UART;
+        transfer->buffer = log_dma_buffers[i];
+        transfer->length = 0;
+        transfer->width = 1;
+        transfer->callback = NULL;
+        transfer->context = NULL;
+        transfer->state = DMAMGR_IDLE;
+        transfer->next = NULL;
+    }
+    log_dma_next = 0;
+    hlog_dma = hdma;
+}
 
-        char buffer[256]; // Adjust the buffer size as needed
-        vsnprintf(buffer, sizeof(buffer), format, args);
+/**
+ * @brief returns 1 while a dma write has not been returned by dmamgr_process
+ */
+static uint8_t log_dma_pending(void) {
+    if (NULL == hlog_dma) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < LOG_DMA_BUFFERS; i++) {
+        if (DMAMGR_IDLE != log_dma_transfers[i].state) {
+            return 1;
+        }
+    }
+    return 0;
+}
 
-        // Output log message through UART using printf
-        printf("%s", buffer);
-        printf("\r\n");
+/**
+ * @brief returns 1 if the caller can wait for the dma interrupt: thread mode
+ *        with interrupts enabled, e.g. not inside a critical section
+ */
+static uint8_t log_dma_can_wait(void) {
+    return (0 == __get_IPSR() && 0 == __get_PRIMASK());
+}
+
+/**
+ * @brief waits for all dma writes, only if log_dma_can_wait: the dma interrupt
+ *        has the same priority as the others and can not preempt them
+ */
+static void log_dma_flush(void) {
+    while (log_dma_pending()) {
+        dmamgr_process(hlog_dma);
+    }
+}
 
-        va_end(args);
+/**
+ * @brief writes raw bytes to the log uart. With dma attached and called from thread
+ *        mode it returns as soon as the last chunk is queued, otherwise blocking
+ * @param data and length
+ * @return none
+ */
+void logWrite(const uint8_t* data, uint16_t len) {
+    if (NULL == hlog_dma || !log_dma_can_wait()) {
+        // an interrupt or critical section can not wait for the dma, dropped like printf output
+        if (log_dma_pending()) {
+            return;
+        }
+        HAL_UART_Transmit(hlog_huart, (uint8_t*) data, len, HAL_MAX_DELAY);
+        return;
+    }
+    while (0 != len) {
+        dmamgr_transfer_t* transfer = &log_dma_transfers[log_dma_next];
+        while (DMAMGR_IDLE != transfer->state) {
+            dmamgr_process(hlog_dma);
+        }
+        uint16_t chunk = (LOG_DMA_BUFFER_SIZE < len) ? LOG_DMA_BUFFER_SIZE : len;
+        memcpy(transfer->buffer, data, chunk);
+        transfer->length = chunk;
+        if (HAL_OK != dmamgr_submit(hlog_dma, transfer)) {
+            log_dma_flush();
+            HAL_UART_Transmit(hlog_huart, (uint8_t*) data, chunk, HAL_MAX_DELAY);
+        }
+        data += chunk;
+        len -= chunk;
+        log_dma_next = (log_dma_next + 1) % LOG_DMA_BUFFERS;
     }
 }
 
+/**
+ * @brief changes baudrate of the log uart, waits for pending output first
+ * @param new baudrate
+ * @return HAL status of uart init
+ */
+HAL_StatusTypeDef logSetBaudRate(uint32_t baudrate) {
+    log_dma_flush();
+    while (RESET == __HAL_UART_GET_FLAG(hlog_huart, UART_FLAG_TC));
+    hlog_huart->Init.BaudRate = baudrate;
+    return HAL_UART_Init(hlog_huart);
+}
 
 //REROUTING PRINTF STUFF
 #ifdef REROUTE_PRINTF
 PUTCHAR_PROTOTYPE {
 
+    if (log_dma_pending()) {
+        // an interrupt or critical section can not wait for the dma, its output would interleave with the stream
+        if (!log_dma_can_wait()) {
+            return ch;
+        }
+        log_dma_flush();
+    }
     HAL_UART_Transmit(hlog_huart, (uint8_t*) &ch, 1, HAL_MAX_DELAY);
 
     return ch;
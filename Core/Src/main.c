@@ -30,6 +30,19 @@
 #include "ui.h"
 #include "event.h"
 #include "pid.h"
+#include "scheduler.h"
+#include "firing.h"
+#include "sysid.h"
+#include "spibus.h"
+#include "w25q.h"
+#include "flashlog.h"
+#include "loadest.h"
+#include "console.h"
+#include "blackbox.h"
+#include "sim.h"
+#include "shadow.h"
+#include "dmamgr.h"
+#include "cycletime.h"
 
 /* USER CODE END Includes */
 
@@ -40,6 +53,7 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define LOG_CHANNEL LOG_CH_MAIN
 #define SW_C_DEBOUNCE_TIME 20
 
 
@@ -64,6 +78,11 @@ TIM_HandleTypeDef htim3;
 UART_HandleTypeDef huart1;
 
 /* USER CODE BEGIN PV */
+//bounds of the code copied to RAM, defined in linker script
+extern uint32_t _sramfunc;
+extern uint32_t _eramfunc;
+extern uint32_t _sdata;
+extern uint32_t _estack;
 
 //for sw_c debouncer
 uint32_t sw_c_last_interrupt_time = 0;
@@ -81,6 +100,36 @@ Ui_HandleTypeDef_t hui;
 
 PID_HandletypeDef_t hpid;
 
+Scheduler_HandleTypeDef_t hsched;
+
+Firing_HandleTypeDef_t hfiring;
+
+Sysid_HandleTypeDef_t hsysid;
+
+Spibus_HandleTypeDef_t hspibus;
+
+W25Q_HandleTypeDef_t hflash;
+
+Flashlog_HandleTypeDef_t hflashlog;
+uint8_t flashlog_present = 0;
+
+Loadest_HandleTypeDef_t hload;
+
+Firestats_HandleTypeDef_t hfirestats;
+
+Console_HandleTypeDef_t hconsole;
+
+Blackbox_HandleTypeDef_t hblackbox;
+
+Sim_HandleTypeDef_t hsim;
+volatile uint16_t sim_ticks_pending = 0; //simulated ticks the main loop still has to run
+
+Shadow_HandleTypeDef_t hshadow;
+
+Dmamgr_HandleTypeDef_t hdmamgr;
+
+Cycletime_HandleTypeDef_t hcycletime;
+
 Event_Queue_HandleTypeDef_t hevent_queue;
 
 
@@ -97,6 +146,8 @@ static void MX_USART1_UART_Init(void);
 static void MX_RTC_Init(void);
 static void MX_TIM3_Init(void);
 /* USER CODE BEGIN PFP */
+static void control_tick(RTC_HandleTypeDef *hrtc);
+static void simulation_run(void);
 
 /* USER CODE END PFP */
 
@@ -142,37 +193,69 @@ int main(void)
   /* USER CODE BEGIN 2 */
   //Init log Feature
   initLog(&huart1);
-  //init temperature
+  //init temperature, shares SPI2 with the log flash
+  initSpibus(&hspibus, &hspi2);
   max31855_init(&htemp,&hspi2);
+  max31855_attach_bus(&htemp, &hspibus);
   //init LCD
   //init Heater
   initHeater(&hheater,&htemp , SW1_GPIO_Port, SW1_Pin, SW2_GPIO_Port, SW2_Pin, SW3_GPIO_Port, SW3_Pin);
+  //coil1..coil3 are wired to L1..L3, balance the phase currents
+  heater_set_phases(&hheater, 0, 1, 2);
   heater_set_level(&hheater, 0);
   lcd1602_init(&hlcd, &hi2c1, 16, 2);
   //init ui
-  initUI(&hui,&hevent_queue, &hlcd);
+  initUI(&hui,&hevent_queue, &hlcd, &hfiring, &hsysid);
   //init encoder
   init_Encoder(&hencoder,&hevent_queue, ENC_A_GPIO_Port, ENC_A_Pin, ENC_B_GPIO_Port, ENC_B_Pin, BUT5_GPIO_Port,BUT5_Pin);
   //init event queue$
   initEvent(&hevent_queue);
+  //init controller and adaptive rate scheduler
+  PID_Init(&hpid, kp_gradient.value, ki_gradient.value, kd_gradient.value, 0, 1.0f);
+  initScheduler(&hsched);
+  heater_init_control(&hheater, &hpid, &hsched);
+  initFiring(&hfiring, &hheater, &hpid, &hsched);
+  initSysid(&hsysid, &hheater);
+  initLoadest(&hload, &hheater);
+  firing_attach_loadest(&hfiring, &hload);
+  initFirestats(&hfirestats, &hheater);
+  firing_attach_stats(&hfiring, &hfirestats);
+  initBlackbox(&hblackbox, &hheater, &hfiring);
+  initSim(&hsim);
+  initShadow(&hshadow, &hheater);
+  initDmamgr(&hdmamgr);
+  log_attach_dma(&hdmamgr, DMAMGR_REQ_USART1_TX);
+  initCycletime(&hcycletime, &hheater);
+  //init firing log, firings are not recorded without the flash
+  if(HAL_OK == initW25q(&hflash, &hspibus) && HAL_OK == initFlashlog(&hflashlog, w25q_get_device(&hflash)))
+  {
+      flashlog_present = 1;
+      firing_attach_log(&hfiring, &hflashlog);
+      LOG_CH_MSG(LOG_CH_FLASHLOG, LOG_INFO, "Flashlog: %lu bytes, firing %u, write 0x%lx", hflash.size, hflashlog.firing_id, hflashlog.write_addr);
+  }
+  else
+  {
+      LOG_CH_MSG(LOG_CH_FLASHLOG, LOG_WARNING, "Flashlog: no flash found");
+  }
 
-  printf("Init complete\r\n");
+  LOG_MSG(LOG_INFO, "RamFunc: %u of %u bytes RAM", (unsigned int)((uint8_t*)&_eramfunc - (uint8_t*)&_sramfunc),
+          (unsigned int)((uint8_t*)&_estack - (uint8_t*)&_sdata));
+  initConsole(&hconsole, &huart1);
+  LOG_MSG(LOG_INFO, "Init complete");
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
-  // Initialize the queue
-  HAL_Delay(40000);
-  printf("ON\r\n");
-  heater_set_level(&hheater, 6);
-  heater_set_state(&hheater);
-  HAL_Delay(100000);
-  printf("OFF\r\n");
-  heater_set_level(&hheater, 0);
-  heater_set_state(&hheater);
-
   while (1)
   {
+      ui_update(&hui);
+      console_process(&hconsole);
+      dmamgr_process(&hdmamgr);
+      simulation_run();
+      if(flashlog_present)
+      {
+          flashlog_process(&hflashlog);
+      }
 
 
 
@@ -566,20 +649,239 @@ static void MX_GPIO_Init(void)
   HAL_NVIC_EnableIRQ(EXTI4_15_IRQn);
 
 /* USER CODE BEGIN MX_GPIO_Init_2 */
+  /*Configure GPIO pin : FLASH_NSS_Pin, idle high */
+  HAL_GPIO_WritePin(FLASH_NSS_GPIO_Port, FLASH_NSS_Pin, GPIO_PIN_SET);
+  GPIO_InitStruct.Pin = FLASH_NSS_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(FLASH_NSS_GPIO_Port, &GPIO_InitStruct);
 /* USER CODE END MX_GPIO_Init_2 */
 }
 
 /* USER CODE BEGIN 4 */
-void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc)
+/*
+ * streams the records of the last firing over the log uart at LOG_BAUDRATE_FAST,
+ * blocking. Waits for pending flash writes first.
+ */
+HAL_StatusTypeDef firing_log_dump(void)
 {
+    if(!flashlog_present)
+    {
+        return HAL_ERROR;
+    }
+    while(!flashlog_is_idle(&hflashlog))
+    {
+        flashlog_process(&hflashlog);
+    }
+    LOG_CH_MSG(LOG_CH_FLASHLOG, LOG_INFO, "Flashlog: dump firing %u at %lu baud", hflashlog.firing_id, (uint32_t)LOG_BAUDRATE_FAST);
+    logSetBaudRate(LOG_BAUDRATE_FAST);
+    HAL_StatusTypeDef status = flashlog_dump(&hflashlog, logWrite);
+    logSetBaudRate(LOG_BAUDRATE_DEFAULT);
+    return status;
+}
 
+/*
+ * prints the black box ring, the control steps before the last reset
+ */
+void blackbox_log_dump(void)
+{
+    blackbox_dump(&hblackbox);
+}
+
+/*
+ * enters simulation with acceleration, 0 leaves it. Only while no firing or
+ * identification runs. The backlight is blue while simulating
+ */
+HAL_StatusTypeDef simulation_set(uint8_t acceleration)
+{
+    if(FIRING_IDLE != hfiring.mode || sysid_is_running(&hsysid))
+    {
+        return HAL_BUSY;
+    }
+    if(0 == acceleration)
+    {
+        heater_set_simulation(&hheater, NULL);
+        sim_ticks_pending = 0;
+        if(flashlog_present)
+        {
+            firing_attach_log(&hfiring, &hflashlog);
+        }
+        LOG_MSG(LOG_INFO, "Simulation off");
+        return lcd1602_setColorWhite(&hlcd);
+    }
+    //restarts from the measured temperature when entered from real operation
+    float32_t temperature = (NULL == hheater.hsim) ? hheater.last_temperature : sim_get_temperature(&hsim);
+    if(HAL_OK != sim_start(&hsim, acceleration, temperature))
+    {
+        return HAL_ERROR;
+    }
+    //dry runs are not recorded as firings
+    firing_attach_log(&hfiring, NULL);
+    heater_set_simulation(&hheater, &hsim);
+    LOG_MSG(LOG_INFO, "Simulation x%u from %dC", acceleration, (int)temperature);
+    return lcd1602_setRGB(&hlcd, 0, 0, 255);
+}
+
+/*
+ * starts the shadow controller with candidate gains, stops it if enable is 0
+ */
+HAL_StatusTypeDef shadow_set(uint8_t enable, float k_p, float k_i, float k_d)
+{
+    if(!enable)
+    {
+        shadow_stop(&hshadow);
+        return HAL_OK;
+    }
+    return shadow_start(&hshadow, k_p, k_i, k_d);
+}
+
+void shadow_log_stats(void)
+{
+    shadow_print_stats(&hshadow);
+}
+
+void dma_log_stats(void)
+{
+    dmamgr_print_stats(&hdmamgr);
+}
+
+void cycle_log_stats(void)
+{
+    cycletime_print_stats(&hcycletime);
+}
+
+/*
+ * the same multiply accumulate as the slope filter, inlined into a flash and a RAM copy
+ */
+static inline __attribute__((always_inline)) float32_t bench_mac(const float32_t* x, uint8_t n)
+{
+    float32_t sum = 0;
+    float32_t t = 0;
+    for(uint8_t i = 0; i < n; i++)
+    {
+        sum += t * (x[i] - x[0]);
+        t += 1.0f;
+    }
+    return sum;
+}
+
+static __attribute__((noinline)) float32_t bench_mac_flash(const float32_t* x, uint8_t n)
+{
+    return bench_mac(x, n);
+}
+
+RAMFUNC static float32_t bench_mac_ram(const float32_t* x, uint8_t n)
+{
+    return bench_mac(x, n);
+}
+
+/*
+ * times flash against RAM execution with the shadow timer, then the RAM placed window
+ * kernels on the live state (pid on a copy). Interrupts are masked per measurement
+ */
+void ramfunc_benchmark(void)
+{
+    uint32_t cycles[5];
+    volatile float32_t sink;
+    PID_HandletypeDef_t pid = hpid;
+    uint8_t n = MAX_MEAS_AR_LENGTH;
+
+    for(uint8_t i = 0; i < 5; i++)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint16_t start = shadow_timer_start();
+        switch(i)
+        {
+            case 0: sink = bench_mac_flash(hheater.temperature, n); break;
+            case 1: sink = bench_mac_ram(hheater.temperature, n); break;
+            case 2: sink = heater_calculate_slope(&hheater); break;
+            case 3: sink = heater_calculate_mean(&hheater); break;
+            default: sink = PID_Calculate(&pid, hheater.mean, hheater.setpoint); break;
+        }
+        cycles[i] = shadow_cycles_since(start);
+        if(!primask)
+        {
+            __enable_irq();
+        }
+    }
+    (void)sink;
+    printf("bench: mac x%u flash %lu ram %lu cycles\r\n", n, (unsigned long)cycles[0], (unsigned long)cycles[1]);
+    printf("bench: slope %lu mean %lu pid %lu cycles\r\n", (unsigned long)cycles[2], (unsigned long)cycles[3],
+            (unsigned long)cycles[4]);
+}
+
+/*
+ * one second of control
+ */
+static void control_tick(RTC_HandleTypeDef *hrtc)
+{
+    firing_on_interupt(&hfiring);
+    sysid_on_interupt(&hsysid);
     heater_on_interupt(&hheater, hrtc);
+    cycletime_on_interupt(&hcycletime);
+    shadow_on_interupt(&hshadow);
+}
+
+/*
+ * runs one pending simulated tick per main loop pass, so the ui and console
+ * stay responsive. If the main loop falls behind the simulation runs slower
+ */
+static void simulation_run(void)
+{
+    if(0 == sim_ticks_pending)
+    {
+        return;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    sim_ticks_pending--;
+    if(!primask)
+    {
+        __enable_irq();
+    }
+    control_tick(&hrtc);
+}
+
+void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc)
+{
+    //the simulation runs acceleration control ticks per second from the main loop
+    if(NULL != hheater.hsim)
+    {
+        if(2U * hsim.acceleration > sim_ticks_pending)
+        {
+            sim_ticks_pending += hsim.acceleration;
+        }
+    }
+    else
+    {
+        control_tick(hrtc);
+    }
+    blackbox_on_interupt(&hblackbox);
 }
 uint8_t counter = 0;
 void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef* htim){
     encoder_callback(&hencoder, 0xff);
 }
 
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if(hconsole.huart == huart)
+    {
+        console_on_receive(&hconsole);
+    }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    //overrun, framing or noise error ends reception, restart it
+    if(hconsole.huart == huart)
+    {
+        console_on_error(&hconsole);
+    }
+}
+
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
     //NOTE: All pins are different Pin but also different Ports
@@ -7,19 +7,19 @@
 
 
 #include "pid.h"
+#include "main.h"
 
 #include <stdio.h>
 
-#include "pid.h"
-
-// Private variables
-static float32_t integral = 0.0f;
-static float32_t last_error = 0.0f;
-static float32_t last_derivative = 0.0f;
 
 
+// Recalculates gains that depend on the sample time
+static void PID_UpdateDiscreteGains(PID_HandletypeDef_t *hpid) {
+    hpid->k_integral_discrete = hpid->k_integral * hpid->sample_time;
+    hpid->k_derivative_discrete = hpid->k_derivative / hpid->sample_time;
+}
 
-// Function to initialize PID controller parameters
+// Function to initialize PID controller parameters, sample time defaults to 1s
 void PID_Init(PID_HandletypeDef_t *hpid, float32_t k_p, float32_t k_i, float32_t k_d,
             float32_t hysteresis, float32_t k_d_filter_coeff) {
     hpid->k_proportional = k_p;
@@ -27,30 +27,109 @@ void PID_Init(PID_HandletypeDef_t *hpid, float32_t k_p, float32_t k_i, float32_t
     hpid->k_derivative = k_d;
     hpid->hysteresis = hysteresis;
     hpid->derivative_filter_coeff = k_d_filter_coeff;
+    hpid->sample_time = 1.0f;
+    hpid->output_min = 0.0f;
+    hpid->output_max = 1.0f;
+    PID_UpdateDiscreteGains(hpid);
+    PID_Reset(hpid, 0.0f);
 }
 
-// Function to update PID controller parameters
+// Function to update PID controller parameters, rescales the integral so the
+// integral term and with it the output does not jump (bumpless)
 void PID_UpdateParameters(PID_HandletypeDef_t *hpid, float32_t k_p, float32_t k_i, float32_t k_d, float32_t hysteresis) {
+    float32_t integral_term = hpid->k_integral_discrete * hpid->integral;
     hpid->k_proportional = k_p;
     hpid->k_integral = k_i;
     hpid->k_derivative = k_d;
     hpid->hysteresis = hysteresis;
+    PID_UpdateDiscreteGains(hpid);
+    if (hpid->k_integral_discrete != 0.0f) {
+        hpid->integral = integral_term / hpid->k_integral_discrete;
+    }
+}
+
+// Function to set the output range of PID_Calculate, e.g. heater levels
+void PID_SetOutputLimits(PID_HandletypeDef_t *hpid, float32_t output_min, float32_t output_max) {
+    hpid->output_min = output_min;
+    hpid->output_max = output_max;
+}
+
+// Function to clear the controller state, current temperature avoids a derivative kick
+void PID_Reset(PID_HandletypeDef_t *hpid, float32_t current_temperature) {
+    hpid->integral = 0.0f;
+    hpid->last_error = 0.0f;
+    hpid->last_derivative = 0.0f;
+    hpid->last_measurement = current_temperature;
+}
+
+// Function to change the sample time, rescales the discrete gains and keeps the
+// time constant of the derivative filter and the integral term (bumpless)
+void PID_SetSampleTime(PID_HandletypeDef_t *hpid, float32_t sample_time) {
+    if (sample_time <= 0.0f || sample_time == hpid->sample_time) {
+        return;
+    }
+    float32_t alpha = hpid->derivative_filter_coeff;
+    if (alpha > 0.0f && alpha < 1.0f) {
+        float32_t tau = hpid->sample_time * (1.0f - alpha) / alpha;
+        hpid->derivative_filter_coeff = sample_time / (tau + sample_time);
+    }
+    float32_t integral_term = hpid->k_integral_discrete * hpid->integral;
+    hpid->sample_time = sample_time;
+    PID_UpdateDiscreteGains(hpid);
+    if (hpid->k_integral_discrete != 0.0f) {
+        hpid->integral = integral_term / hpid->k_integral_discrete;
+    }
+}
+
+// Function to calculate continuous PID output limited to output_min..output_max.
+// The derivative acts on the measurement so setpoint changes do not kick the output,
+// the integral only grows while the output is not saturated (anti windup)
+RAMFUNC float32_t PID_Calculate(PID_HandletypeDef_t *hpid, float32_t current_temperature, float32_t setpoint) {
+    float32_t error = setpoint - current_temperature;
+    float32_t derivative = hpid->last_measurement - current_temperature;
+    // Apply derivative filtering
+    float32_t filtered_derivative = (1.0f - hpid->derivative_filter_coeff) * hpid->last_derivative +
+                                         hpid->derivative_filter_coeff * derivative;
+    hpid->last_derivative = filtered_derivative;
+    hpid->last_measurement = current_temperature;
+    hpid->last_error = error;
+
+    float32_t integral = hpid->integral + error;
+    float32_t output = hpid->k_proportional * error +
+                       hpid->k_integral_discrete * integral +
+                       hpid->k_derivative_discrete * filtered_derivative;
+
+    if (output > hpid->output_max) {
+        output = hpid->output_max;
+        if (error < 0.0f) {
+            hpid->integral = integral;
+        }
+    } else if (output < hpid->output_min) {
+        output = hpid->output_min;
+        if (error > 0.0f) {
+            hpid->integral = integral;
+        }
+    } else {
+        hpid->integral = integral;
+    }
+    return output;
 }
 
 // Function to calculate PID output with hysteresis
 PID_Controller_Output_t PID_CalculateOutput(PID_HandletypeDef_t *hpid, float32_t current_temperature, float32_t setpoint) {
     float32_t error = setpoint - current_temperature;
-    integral += error;
-    float32_t derivative = error - last_error;
+    hpid->integral += error;
+    float32_t derivative = error - hpid->last_error;
     // Apply derivative filtering
-    float32_t filtered_derivative = (1.0f - hpid->derivative_filter_coeff) * last_derivative +
+    float32_t filtered_derivative = (1.0f - hpid->derivative_filter_coeff) * hpid->last_derivative +
                                          hpid->derivative_filter_coeff * derivative;
-    last_derivative = filtered_derivative;
-    last_error = error;
+    hpid->last_derivative = filtered_derivative;
+    hpid->last_error = error;
+    hpid->last_measurement = current_temperature;
     // Calculate PID output
     float32_t output = hpid->k_proportional * error +
-                       hpid->k_integral * integral +
-                       hpid->k_derivative * derivative;
+                       hpid->k_integral_discrete * hpid->integral +
+                       hpid->k_derivative_discrete * derivative;
 
     // Apply hysteresis
     if (output > hpid->hysteresis) {
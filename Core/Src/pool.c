@@ -0,0 +1,165 @@
+/*
+ * pool.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+
+void* _sbrk(ptrdiff_t incr);
+extern uint8_t _end;            //start of the heap, defined in linker script
+extern uint8_t _Min_Heap_Size;  //heap reservation, its address is the value
+
+//initialized pools for the statistics
+static Pool_HandleTypeDef_t* pool_list[POOL_MAX_POOLS];
+static uint8_t pool_count = 0;
+
+#ifdef POOL_DEBUG
+/*
+ * fills block but the free list pointer with poison
+ */
+static void pool_poison(Pool_HandleTypeDef_t* hpool, pool_block_t* block)
+{
+    memset((uint8_t*)block + sizeof(pool_block_t), POOL_POISON, hpool->block_size - sizeof(pool_block_t));
+}
+
+/*
+ * returns 1 if the poison of a free block is intact
+ */
+static uint8_t pool_check_poison(Pool_HandleTypeDef_t* hpool, pool_block_t* block)
+{
+    const uint8_t* data = (const uint8_t*)block;
+    for(uint16_t i = sizeof(pool_block_t); i < hpool->block_size; i++)
+    {
+        if(POOL_POISON != data[i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+#endif
+
+/*
+ * init function of a pool, links all blocks of memory into the free list
+ */
+HAL_StatusTypeDef initPool(Pool_HandleTypeDef_t* hpool, const char* name, uint32_t* memory, uint16_t block_size, uint16_t blocks)
+{
+    if(NULL == hpool || NULL == memory || 0 == blocks)
+    {
+        return HAL_ERROR;
+    }
+    hpool->name = name;
+    hpool->memory = (uint8_t*)memory;
+    hpool->block_size = POOL_BLOCK_WORDS(block_size) * 4U;
+    hpool->blocks = blocks;
+    hpool->used = 0;
+    hpool->high_water = 0;
+    hpool->failures = 0;
+#ifdef POOL_DEBUG
+    hpool->corruptions = 0;
+#endif
+
+    hpool->free = NULL;
+    for(uint16_t i = blocks; i > 0; i--)
+    {
+        pool_block_t* block = (pool_block_t*)(hpool->memory + (i - 1) * hpool->block_size);
+        block->next = hpool->free;
+#ifdef POOL_DEBUG
+        pool_poison(hpool, block);
+#endif
+        hpool->free = block;
+    }
+
+    if(POOL_MAX_POOLS > pool_count)
+    {
+        pool_list[pool_count++] = hpool;
+    }
+    return HAL_OK;
+}
+
+/*
+ * takes a block from the pool, NULL if it is empty. ISR safe
+ */
+void* pool_alloc(Pool_HandleTypeDef_t* hpool)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    pool_block_t* block = hpool->free;
+    if(NULL == block)
+    {
+        hpool->failures++;
+    }
+    else
+    {
+        hpool->free = block->next;
+        hpool->used++;
+        if(hpool->used > hpool->high_water)
+        {
+            hpool->high_water = hpool->used;
+        }
+#ifdef POOL_DEBUG
+        if(!pool_check_poison(hpool, block))
+        {
+            hpool->corruptions++;
+        }
+#endif
+    }
+    if(!primask)
+    {
+        __enable_irq();
+    }
+    return block;
+}
+
+/*
+ * returns a block to the pool, NULL is ignored. ISR safe
+ */
+void pool_free(Pool_HandleTypeDef_t* hpool, void* block)
+{
+    if(NULL == block)
+    {
+        return;
+    }
+#ifdef POOL_DEBUG
+    uint32_t offset = (uint8_t*)block - hpool->memory;
+    if((uint8_t*)block < hpool->memory || offset >= (uint32_t)hpool->blocks * hpool->block_size
+            || 0 != offset % hpool->block_size)
+    {
+        hpool->corruptions++;
+        return;
+    }
+    pool_poison(hpool, (pool_block_t*)block);
+#endif
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ((pool_block_t*)block)->next = hpool->free;
+    hpool->free = (pool_block_t*)block;
+    hpool->used--;
+    if(!primask)
+    {
+        __enable_irq();
+    }
+}
+
+/*
+ * prints use of all pools
+ */
+void pool_print_stats(void)
+{
+    for(uint8_t i = 0; i < pool_count; i++)
+    {
+        Pool_HandleTypeDef_t* hpool = pool_list[i];
+        printf("%-8s %2u x %3uB used %u max %u fail %u", hpool->name, hpool->blocks, hpool->block_size,
+                hpool->used, hpool->high_water, hpool->failures);
+#ifdef POOL_DEBUG
+        printf(" corrupt %u", hpool->corruptions);
+#endif
+        printf("\r\n");
+    }
+    printf("heap     %u of %uB\r\n", (unsigned int)((uint8_t*)_sbrk(0) - &_end), (unsigned int)(uintptr_t)&_Min_Heap_Size);
+}
@@ -0,0 +1,159 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "scheduler.h"
+
+//rate sets indexed by scheduler_rate_t
+static const scheduler_rates_t scheduler_rate_table[] =
+{
+    {SCHEDULER_FAST_SAMPLING, SCHEDULER_FAST_PID, SCHEDULER_FAST_LOG},
+    {SCHEDULER_NORMAL_SAMPLING, SCHEDULER_NORMAL_PID, SCHEDULER_NORMAL_LOG},
+    {SCHEDULER_SLOW_SAMPLING, SCHEDULER_SLOW_PID, SCHEDULER_SLOW_LOG}
+};
+
+/*
+ * init function of scheduler instance, starts at normal rate without target
+ */
+HAL_StatusTypeDef initScheduler(Scheduler_HandleTypeDef_t* hsched)
+{
+    if(NULL == hsched)
+    {
+        return HAL_ERROR;
+    }
+    hsched->rate = SCHEDULER_RATE_NORMAL;
+    hsched->phase = SCHEDULER_PHASE_IDLE;
+    hsched->target_valid = 0;
+    hsched->transition = 0;
+    hsched->calm_count = 0;
+    hsched->target_temperature = 0;
+    hsched->target_gradient = 0;
+    return HAL_OK;
+}
+
+/*
+ * sets target of current segment, a changed target is treated as segment transition
+ */
+void scheduler_set_target(Scheduler_HandleTypeDef_t* hsched, float32_t temperature, float32_t gradient)
+{
+    if(!hsched->target_valid || temperature != hsched->target_temperature
+            || gradient != hsched->target_gradient)
+    {
+        hsched->transition = 1;
+    }
+    hsched->target_valid = 1;
+    hsched->target_temperature = temperature;
+    hsched->target_gradient = gradient;
+}
+
+/*
+ * removes target, heater is off and the loop falls back to the slow rate
+ */
+void scheduler_clear_target(Scheduler_HandleTypeDef_t* hsched)
+{
+    hsched->target_valid = 0;
+    hsched->transition = 0;
+}
+
+/*
+ * derives segment phase from target and measured mean temperature
+ */
+static scheduler_phase_t scheduler_get_phase(Scheduler_HandleTypeDef_t* hsched, float32_t slope, float32_t mean)
+{
+    if(!hsched->target_valid)
+    {
+        return SCHEDULER_PHASE_IDLE;
+    }
+
+    float32_t distance = fabsf(hsched->target_temperature - mean);
+    if(SCHEDULER_SETTLED_BAND >= distance && SCHEDULER_SLOPE_ERROR_SLOW >= fabsf(slope))
+    {
+        return SCHEDULER_PHASE_HOLD;
+    }
+    if(SCHEDULER_APPROACH_BAND >= distance)
+    {
+        return SCHEDULER_PHASE_APPROACH;
+    }
+    return (hsched->target_temperature > mean) ? SCHEDULER_PHASE_RAMP : SCHEDULER_PHASE_COOL;
+}
+
+/*
+ * evaluates slope [C/h] and mean temperature [C] of the last pid window and selects
+ * the rate for the next window. Steps up immediately, steps down one rate after
+ * SCHEDULER_CALM_WINDOWS calm windows. Returns 1 if the rate changed.
+ */
+uint8_t scheduler_update(Scheduler_HandleTypeDef_t* hsched, float32_t slope, float32_t mean)
+{
+    scheduler_rate_t wanted;
+    scheduler_rate_t prev = hsched->rate;
+
+    hsched->phase = scheduler_get_phase(hsched, slope, mean);
+    float32_t slope_error = fabsf(slope - hsched->target_gradient);
+
+    switch (hsched->phase) {
+        case SCHEDULER_PHASE_IDLE:
+            wanted = SCHEDULER_RATE_SLOW;
+            break;
+        case SCHEDULER_PHASE_APPROACH:
+            wanted = SCHEDULER_RATE_FAST;
+            break;
+        case SCHEDULER_PHASE_HOLD:
+            wanted = SCHEDULER_RATE_SLOW;
+            break;
+        case SCHEDULER_PHASE_RAMP:
+        case SCHEDULER_PHASE_COOL:
+        default:
+            if(SCHEDULER_SLOPE_ERROR_FAST <= slope_error)
+            {
+                wanted = SCHEDULER_RATE_FAST;
+            }
+            else if(SCHEDULER_SLOPE_ERROR_SLOW >= slope_error)
+            {
+                wanted = SCHEDULER_RATE_SLOW;
+            }
+            else
+            {
+                wanted = SCHEDULER_RATE_NORMAL;
+            }
+            break;
+    }
+
+    //segment transitions always run fast
+    if(hsched->transition)
+    {
+        wanted = SCHEDULER_RATE_FAST;
+        hsched->transition = 0;
+    }
+
+    if(wanted < hsched->rate)
+    {
+        hsched->rate = wanted;
+        hsched->calm_count = 0;
+    }
+    else if(wanted > hsched->rate)
+    {
+        hsched->calm_count++;
+        if(SCHEDULER_CALM_WINDOWS <= hsched->calm_count)
+        {
+            hsched->rate++;
+            hsched->calm_count = 0;
+        }
+    }
+    else
+    {
+        hsched->calm_count = 0;
+    }
+
+    return (prev != hsched->rate);
+}
+
+/*
+ * returns intervals of the currently selected rate
+ */
+scheduler_rates_t scheduler_get_rates(Scheduler_HandleTypeDef_t* hsched)
+{
+    return scheduler_rate_table[hsched->rate];
+}
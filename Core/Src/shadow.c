@@ -0,0 +1,173 @@
+/*
+ * shadow.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "shadow.h"
+#include "log.h"
+#include <stdio.h>
+
+#define LOG_CHANNEL LOG_CH_SHADOW
+
+/*
+ * init function of shadow controller, not running afterwards
+ */
+HAL_StatusTypeDef initShadow(Shadow_HandleTypeDef_t* hshadow, Heater_HandleTypeDef_t* hheater)
+{
+    if(NULL == hshadow || NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    hshadow->running = 0;
+    hshadow->hheater = hheater;
+
+    __HAL_RCC_TIM14_CLK_ENABLE();
+    SHADOW_TIMER->PSC = SHADOW_TIMER_PRESCALER - 1U;
+    SHADOW_TIMER->ARR = 0xFFFFU;
+    SHADOW_TIMER->EGR = TIM_EGR_UG;
+    SHADOW_TIMER->SR = 0;
+    SHADOW_TIMER->CR1 = TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+/*
+ * starts shadowing the live pid with candidate gains, clears the statistics.
+ * Hysteresis and derivative filter are taken from the live pid
+ */
+HAL_StatusTypeDef shadow_start(Shadow_HandleTypeDef_t* hshadow, float32_t k_p, float32_t k_i, float32_t k_d)
+{
+    Heater_HandleTypeDef_t* hheater = hshadow->hheater;
+    if(NULL == hheater->hpid)
+    {
+        return HAL_ERROR;
+    }
+    hshadow->running = 0;
+    PID_Init(&hshadow->pid, k_p, k_i, k_d, hheater->hpid->hysteresis, hheater->hpid->derivative_filter_coeff);
+    PID_SetOutputLimits(&hshadow->pid, 0, HEATER_MAX_LEVEL);
+    PID_SetSampleTime(&hshadow->pid, hheater->pid_interval);
+    //the live pid state is the best start if control already runs
+    hshadow->pid.integral = hheater->hpid->integral;
+    hshadow->pid.last_measurement = hheater->hpid->last_measurement;
+    hshadow->pid.last_derivative = hheater->hpid->last_derivative;
+
+    hshadow->last_control = hheater->control_enabled;
+    hshadow->last_window = hheater->window_count;
+    hshadow->level = 0;
+    hshadow->windows = 0;
+    hshadow->agree = 0;
+    hshadow->sum_diff = 0;
+    hshadow->sum_abs = 0;
+    hshadow->max_abs = 0;
+    hshadow->cycles = 0;
+    hshadow->cycles_max = 0;
+    hshadow->running = 1;
+    return HAL_OK;
+}
+
+void shadow_stop(Shadow_HandleTypeDef_t* hshadow)
+{
+    hshadow->running = 0;
+}
+
+/*
+ * starts a measurement on SHADOW_TIMER, returns the count for shadow_cycles_since
+ */
+uint16_t shadow_timer_start(void)
+{
+    SHADOW_TIMER->SR = 0;
+    return (uint16_t)SHADOW_TIMER->CNT;
+}
+
+/*
+ * core clock cycles since shadow_timer_start.
+ * A wrap with the count past start means a whole period passed, reported as UINT32_MAX
+ */
+uint32_t shadow_cycles_since(uint16_t start)
+{
+    uint16_t now = (uint16_t)SHADOW_TIMER->CNT;
+    if((SHADOW_TIMER->SR & TIM_SR_UIF) && now >= start)
+    {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(uint16_t)(now - start) * SHADOW_TIMER_PRESCALER;
+}
+
+/*
+ * runs the shadow pid on the sample of the finished window and compares it with the live level
+ */
+static void shadow_compare(Shadow_HandleTypeDef_t* hshadow)
+{
+    Heater_HandleTypeDef_t* hheater = hshadow->hheater;
+
+    uint16_t start = shadow_timer_start();
+    //the live pid ran on the finished window, the scheduler may have set the next interval since
+    PID_SetSampleTime(&hshadow->pid, hheater->window_interval);
+    PID_SetOutputLimits(&hshadow->pid, -hheater->feedforward, HEATER_MAX_LEVEL - hheater->feedforward);
+    float32_t output = PID_Calculate(&hshadow->pid, hheater->mean, hheater->setpoint) + hheater->feedforward;
+    hshadow->level = (uint8_t)(output + 0.5f);
+    hshadow->cycles = shadow_cycles_since(start);
+
+    int8_t diff = (int8_t)hshadow->level - (int8_t)hheater->pid_level;
+    uint8_t diff_abs = (0 > diff) ? -diff : diff;
+    hshadow->windows++;
+    hshadow->agree += (0 == diff);
+    hshadow->sum_diff += diff;
+    hshadow->sum_abs += diff_abs;
+    hshadow->max_abs = (diff_abs > hshadow->max_abs) ? diff_abs : hshadow->max_abs;
+    hshadow->cycles_max = (hshadow->cycles > hshadow->cycles_max) ? hshadow->cycles : hshadow->cycles_max;
+
+    LOG_MSG(LOG_INFO, "SHADOW,%u,%u,%u,%.2f,%lu", hheater->window_count, hheater->pid_level, hshadow->level,
+            output, (unsigned long)hshadow->cycles);
+
+    if(SHADOW_MAX_CYCLES < hshadow->cycles)
+    {
+        LOG_MSG(LOG_WARNING, "SHADOW: %lu cycles over budget, stopped", (unsigned long)hshadow->cycles);
+        hshadow->running = 0;
+    }
+}
+
+/*
+ * follows the heater and compares at the end of every pid window, called every RTC interrupt
+ */
+void shadow_on_interupt(Shadow_HandleTypeDef_t* hshadow)
+{
+    if(!hshadow->running)
+    {
+        return;
+    }
+    Heater_HandleTypeDef_t* hheater = hshadow->hheater;
+
+    //new firing, the live pid was reset as well
+    if(hheater->control_enabled && !hshadow->last_control)
+    {
+        PID_Reset(&hshadow->pid, hheater->last_temperature);
+    }
+    hshadow->last_control = hheater->control_enabled;
+
+    if(hshadow->last_window == hheater->window_count)
+    {
+        return;
+    }
+    hshadow->last_window = hheater->window_count;
+    if(hheater->control_enabled)
+    {
+        shadow_compare(hshadow);
+    }
+}
+
+/*
+ * prints divergence statistics and cost
+ */
+void shadow_print_stats(Shadow_HandleTypeDef_t* hshadow)
+{
+    uint32_t windows = (0 == hshadow->windows) ? 1 : hshadow->windows;
+    printf("shadow %s kp %.3f ki %.5f kd %.3f\r\n", hshadow->running ? "on" : "off",
+            hshadow->pid.k_proportional, hshadow->pid.k_integral, hshadow->pid.k_derivative);
+    printf("windows %lu agree %lu%% bias %.2f mean |d| %.2f max |d| %u\r\n", (unsigned long)hshadow->windows,
+            (unsigned long)(hshadow->agree * 100U / windows), (float32_t)hshadow->sum_diff / windows,
+            (float32_t)hshadow->sum_abs / windows, hshadow->max_abs);
+    printf("cycles %lu max %lu budget %lu\r\n", (unsigned long)hshadow->cycles, (unsigned long)hshadow->cycles_max,
+            (unsigned long)SHADOW_MAX_CYCLES);
+}
@@ -0,0 +1,62 @@
+/*
+ * sim.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "sim.h"
+#include "main.h"
+
+#define SIM_Q16(x) ((int32_t)(x) << 16)
+
+/*
+ * init function of kiln model, cold kiln without acceleration
+ */
+HAL_StatusTypeDef initSim(Sim_HandleTypeDef_t* hsim)
+{
+    if(NULL == hsim)
+    {
+        return HAL_ERROR;
+    }
+    hsim->acceleration = 1;
+    hsim->chamber = SIM_Q16(SIM_AMBIENT);
+    hsim->sensor = SIM_Q16(SIM_AMBIENT);
+    return HAL_OK;
+}
+
+/*
+ * restarts the model at temperature, acceleration 1..SIM_MAX_ACCELERATION
+ */
+HAL_StatusTypeDef sim_start(Sim_HandleTypeDef_t* hsim, uint8_t acceleration, float32_t temperature)
+{
+    if(NULL == hsim || 0 == acceleration || SIM_MAX_ACCELERATION < acceleration)
+    {
+        return HAL_ERROR;
+    }
+    if(SIM_AMBIENT > temperature)
+    {
+        temperature = SIM_AMBIENT;
+    }
+    hsim->acceleration = acceleration;
+    hsim->chamber = (int32_t)(temperature * 65536.0f);
+    hsim->sensor = hsim->chamber;
+    return HAL_OK;
+}
+
+/*
+ * advances the model by one second with the heater level as input
+ */
+void sim_step(Sim_HandleTypeDef_t* hsim, uint8_t level)
+{
+    hsim->chamber += (int32_t)level * SIM_GAIN_PER_LEVEL - (hsim->chamber - SIM_Q16(SIM_AMBIENT)) / SIM_LOSS_TAU;
+    hsim->sensor += (hsim->chamber - hsim->sensor) / SIM_SENSOR_TAU;
+}
+
+/*
+ * modelled thermocouple temperature [C]
+ */
+float32_t sim_get_temperature(Sim_HandleTypeDef_t* hsim)
+{
+    return (float32_t)hsim->sensor / 65536.0f;
+}
@@ -0,0 +1,58 @@
+/*
+ * spibus.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "spibus.h"
+
+/*
+ * init function of bus instance, bus is free afterwards
+ */
+HAL_StatusTypeDef initSpibus(Spibus_HandleTypeDef_t* hbus, SPI_HandleTypeDef* hspi)
+{
+    if(NULL == hbus || NULL == hspi)
+    {
+        return HAL_ERROR;
+    }
+    hbus->hspi = hspi;
+    hbus->owner = SPIBUS_DEVICE_NONE;
+    hbus->contention_count = 0;
+    return HAL_OK;
+}
+
+/*
+ * takes ownership of the bus for device, HAL_BUSY if another device owns it
+ */
+HAL_StatusTypeDef spibus_acquire(Spibus_HandleTypeDef_t* hbus, spibus_device_t device)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if(SPIBUS_DEVICE_NONE == hbus->owner || device == hbus->owner)
+    {
+        hbus->owner = device;
+    }
+    else
+    {
+        hbus->contention_count++;
+        status = HAL_BUSY;
+    }
+    if(!primask)
+    {
+        __enable_irq();
+    }
+    return status;
+}
+
+/*
+ * gives up ownership, ignored if device does not own the bus
+ */
+void spibus_release(Spibus_HandleTypeDef_t* hbus, spibus_device_t device)
+{
+    if(device == hbus->owner)
+    {
+        hbus->owner = SPIBUS_DEVICE_NONE;
+    }
+}
@@ -22,6 +22,7 @@
 #include "stm32f0xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "dmamgr.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -59,6 +60,7 @@ extern RTC_HandleTypeDef hrtc;
 extern TIM_HandleTypeDef htim3;
 extern UART_HandleTypeDef huart1;
 /* USER CODE BEGIN EV */
+extern Dmamgr_HandleTypeDef_t hdmamgr;
 
 /* USER CODE END EV */
 
@@ -231,5 +233,22 @@ void USART1_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief DMA1 channel interrupts, all channels are owned by the DMA manager
+  */
+void DMA1_Channel1_IRQHandler(void)
+{
+  dmamgr_on_interupt(&hdmamgr);
+}
+
+void DMA1_Channel2_3_IRQHandler(void)
+{
+  dmamgr_on_interupt(&hdmamgr);
+}
+
+void DMA1_Channel4_5_IRQHandler(void)
+{
+  dmamgr_on_interupt(&hdmamgr);
+}
 
 /* USER CODE END 1 */
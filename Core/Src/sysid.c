@@ -0,0 +1,176 @@
+/*
+ * sysid.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "sysid.h"
+
+#define LOG_CHANNEL LOG_CH_SYSID
+
+//periods of the stepped sweep [s], slow to fast
+static const uint16_t sysid_periods[] = {3600, 1800, 900, 480, 240};
+#define SYSID_FREQ_COUNT (sizeof(sysid_periods) / sizeof(sysid_periods[0]))
+
+//one period of sine in Q15
+static const int16_t sysid_sine[SYSID_SINE_LENGTH] =
+{
+         0,   3212,   6393,   9512,  12539,  15446,  18204,  20787,
+     23170,  25329,  27245,  28898,  30273,  31356,  32137,  32609,
+     32767,  32609,  32137,  31356,  30273,  28898,  27245,  25329,
+     23170,  20787,  18204,  15446,  12539,   9512,   6393,   3212,
+         0,  -3212,  -6393,  -9512, -12539, -15446, -18204, -20787,
+    -23170, -25329, -27245, -28898, -30273, -31356, -32137, -32609,
+    -32767, -32609, -32137, -31356, -30273, -28898, -27245, -25329,
+    -23170, -20787, -18204, -15446, -12539,  -9512,  -6393,  -3212
+};
+
+/*
+ * init function of sysid instance
+ */
+HAL_StatusTypeDef initSysid(Sysid_HandleTypeDef_t* hsysid, Heater_HandleTypeDef_t* hheater)
+{
+    if(NULL == hsysid || NULL == hheater)
+    {
+        return HAL_ERROR;
+    }
+    hsysid->hheater = hheater;
+    hsysid->running = 0;
+    hsysid->offset = 0;
+    return HAL_OK;
+}
+
+/*
+ * clears accumulators and restarts the time base for the current frequency
+ */
+static void sysid_reset_frequency(Sysid_HandleTypeDef_t* hsysid)
+{
+    hsysid->time = 0;
+    hsysid->y_re = 0;
+    hsysid->y_im = 0;
+    hsysid->u_re = 0;
+    hsysid->u_im = 0;
+}
+
+/*
+ * starts a sweep around the current setpoint, heater needs to run closed loop
+ */
+HAL_StatusTypeDef sysid_start(Sysid_HandleTypeDef_t* hsysid)
+{
+    if(NULL == hsysid || !hsysid->hheater->control_enabled)
+    {
+        return HAL_ERROR;
+    }
+    hsysid->operating_point = hsysid->hheater->setpoint;
+    hsysid->freq_index = 0;
+    sysid_reset_frequency(hsysid);
+    hsysid->running = 1;
+    LOG_MSG(LOG_INFO, "SYSID: start at %.1f C", hsysid->operating_point);
+    return HAL_OK;
+}
+
+/*
+ * aborts sweep and removes perturbation
+ */
+HAL_StatusTypeDef sysid_stop(Sysid_HandleTypeDef_t* hsysid)
+{
+    if(NULL == hsysid)
+    {
+        return HAL_ERROR;
+    }
+    hsysid->running = 0;
+    hsysid->offset = 0;
+    return heater_set_demand_offset(hsysid->hheater, 0);
+}
+
+uint8_t sysid_is_running(Sysid_HandleTypeDef_t* hsysid)
+{
+    return hsysid->running;
+}
+
+/*
+ * converts accumulators of the finished frequency into gain and phase and logs them
+ */
+static void sysid_report(Sysid_HandleTypeDef_t* hsysid, uint16_t period)
+{
+    float32_t y_re = (float32_t)hsysid->y_re;
+    float32_t y_im = (float32_t)hsysid->y_im;
+    float32_t u_re = (float32_t)hsysid->u_re;
+    float32_t u_im = (float32_t)hsysid->u_im;
+
+    float32_t u_abs = sqrtf(u_re * u_re + u_im * u_im);
+    if(0.0f == u_abs)
+    {
+        LOG_MSG(LOG_WARNING, "SYSID: no excitation at %u s", period);
+        return;
+    }
+    float32_t gain = sqrtf(y_re * y_re + y_im * y_im) / u_abs;
+    float32_t phase = (atan2f(y_im, y_re) - atan2f(u_im, u_re)) * 180.0f / PI;
+    if(180.0f < phase)
+    {
+        phase -= 360.0f;
+    }
+    else if(-180.0f >= phase)
+    {
+        phase += 360.0f;
+    }
+    LOG_MSG(LOG_INFO, "SYSID,%.1f,%u,%.3f,%.1f", hsysid->operating_point, period, gain, phase);
+}
+
+/*
+ * advances the sweep by one interrupt interval: sets perturbation and correlates
+ * temperature and applied level with the reference of the current frequency
+ */
+void sysid_on_interupt(Sysid_HandleTypeDef_t* hsysid)
+{
+    if(!hsysid->running)
+    {
+        return;
+    }
+    Heater_HandleTypeDef_t* hheater = hsysid->hheater;
+    if(!hheater->control_enabled)
+    {
+        //closed loop was stopped underneath us
+        sysid_stop(hsysid);
+        return;
+    }
+
+    uint16_t period = sysid_periods[hsysid->freq_index];
+    uint32_t index = ((hsysid->time % period) * SYSID_SINE_LENGTH) / period;
+    int32_t sine = sysid_sine[index];
+    int32_t cosine = sysid_sine[(index + SYSID_SINE_LENGTH / 4) % SYSID_SINE_LENGTH];
+
+    //square wave in phase with the reference sine
+    int8_t offset = (0 <= sine) ? SYSID_AMPLITUDE : -SYSID_AMPLITUDE;
+    if(offset != hsysid->offset)
+    {
+        hsysid->offset = offset;
+        heater_set_demand_offset(hheater, offset);
+    }
+
+    //first period settles, then correlate. Y = sum(y * e^-jwt)
+    if(period <= hsysid->time)
+    {
+        int32_t y = (int32_t)((hheater->last_temperature - hsysid->operating_point) * (1 << SYSID_SAMPLE_SHIFT));
+        int32_t u = (int32_t)hheater->heater_level << SYSID_SAMPLE_SHIFT;
+        hsysid->y_re += (int64_t)y * cosine;
+        hsysid->y_im -= (int64_t)y * sine;
+        hsysid->u_re += (int64_t)u * cosine;
+        hsysid->u_im -= (int64_t)u * sine;
+    }
+
+    hsysid->time += INTERUPT_INTERVAL_SECONDS;
+    if((uint32_t)period * (1 + SYSID_PERIODS) <= hsysid->time)
+    {
+        sysid_report(hsysid, period);
+        hsysid->freq_index++;
+        if(SYSID_FREQ_COUNT <= hsysid->freq_index)
+        {
+            LOG_MSG(LOG_INFO, "SYSID: done");
+            sysid_stop(hsysid);
+            return;
+        }
+        sysid_reset_frequency(hsysid);
+    }
+}
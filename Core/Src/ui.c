@@ -7,6 +7,8 @@
 
 #include "ui.h"
 
+#define LOG_CHANNEL LOG_CH_UI
+
 static ui_program_t p1 = {3,{288,300,150},{0,1,1},{200,80,120}};
 static ui_program_t p2 = {5,{80,60,150,300,80},{0,1,0,0,1},{15,80,120,300,600}};
 static ui_program_t p3 = {2,{300,150},{0,0},{300,80}};
@@ -29,6 +31,11 @@ static uint16_t temp_counter = 0;
 static uint16_t temp_counter_single = 0;
 static uint8_t temp_sign = 0;
 static uint8_t temp_bool = 0;
+//target of setpoint hold mode
+static uint16_t setpoint_target = SETPOINT_DEFAULT_TEMPERATURE;
+//segment and value selected in running program view
+static uint8_t run_segment = 0;
+static ui_run_field_t run_field = RUN_FIELD_NONE;
 
 //empty char
 char empty_text_buf[UI_LCD_CHAR_SIZE] = "                \n";
@@ -62,10 +69,13 @@ uint8_t degree[] = {
 /*
  * init function for ui struct handle
  */
-void initUI(Ui_HandleTypeDef_t* ui, Event_Queue_HandleTypeDef_t *queue, LCD1602_RGB_HandleTypeDef_t *hlcd)
+void initUI(Ui_HandleTypeDef_t* ui, Event_Queue_HandleTypeDef_t *queue, LCD1602_RGB_HandleTypeDef_t *hlcd,
+        Firing_HandleTypeDef_t *hfiring, Sysid_HandleTypeDef_t *hsysid)
 {
     ui->hlcd = hlcd;
     ui->queue = queue;
+    ui->hfiring = hfiring;
+    ui->hsysid = hsysid;
     ui->state = PROGRAMS;
     ui->last_state = NO_MENUPOINT;
 
@@ -226,9 +236,7 @@ static HAL_StatusTypeDef ui_update_(Ui_HandleTypeDef_t *ui,event_type_t event)
 
             break;
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
 
@@ -344,9 +352,7 @@ static HAL_StatusTypeDef ui_update_create_program_detailed(Ui_HandleTypeDef_t *u
 
             break;
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
     //update program values according according to scroll_counter:
@@ -408,9 +414,7 @@ static HAL_StatusTypeDef ui_update_create_program(Ui_HandleTypeDef_t *ui,event_t
             ui->state = PROGRAMS_OVERVIEW;
             break;
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
 
@@ -450,7 +454,25 @@ static HAL_StatusTypeDef ui_update_program_detailed(Ui_HandleTypeDef_t *ui,event
             scroll_counter = 0;
             break;
         case BUT4:      // start / stop
-
+            if(!firing_is_running(ui->hfiring))
+            {
+                firing_segment_t segments[MAX_PROGRAM_SEQ_LENGTH];
+                for (uint8_t i = 0; i < program.length; ++i) {
+                    segments[i].gradient = program.gradient[i];
+                    segments[i].target = program.temperature[i];
+                    segments[i].hold = 0;
+                    segments[i].cone = 0;
+                }
+                if(HAL_OK == firing_start_program(ui->hfiring, segments, program.length, ui->settings.setting_list[0].value,
+                        ui->settings.setting_list[1].value, ui->settings.setting_list[2].value))
+                {
+                    run_segment = 0;
+                    run_field = RUN_FIELD_NONE;
+                    scroll_counter = 0;
+                    ui->state = PROGRAM_RUNNING;
+                    return HAL_OK;
+                }
+            }
             break;
         case ENC_BUT:   // Enter
             ui->state = PROGRAMS_OVERVIEW;
@@ -465,9 +487,7 @@ static HAL_StatusTypeDef ui_update_program_detailed(Ui_HandleTypeDef_t *ui,event
             else scroll_counter--;
             break;
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
 
@@ -528,9 +548,7 @@ static HAL_StatusTypeDef ui_update_programs_overview(Ui_HandleTypeDef_t *ui,even
             }
             break;
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
 
@@ -629,9 +647,7 @@ static HAL_StatusTypeDef ui_update_settings_overview(Ui_HandleTypeDef_t *ui,even
             break;
 
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
     index = ui->settings.cur_index;
@@ -671,7 +687,7 @@ static HAL_StatusTypeDef ui_update_programs(Ui_HandleTypeDef_t *ui,event_type_t
             //nothing
             break;
         case ENC_BUT:   // Enter
-            ui->state = PROGRAMS_OVERVIEW;
+            ui->state = (FIRING_PROGRAM == ui->hfiring->mode) ? PROGRAM_RUNNING : PROGRAMS_OVERVIEW;
             break;
         case ENC_UP:    // navigate right / up
             ui->state = SETPOINT;
@@ -680,9 +696,7 @@ static HAL_StatusTypeDef ui_update_programs(Ui_HandleTypeDef_t *ui,event_type_t
             ui->state = SETTINGS;
             break;
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
 
@@ -692,6 +706,283 @@ static HAL_StatusTypeDef ui_update_programs(Ui_HandleTypeDef_t *ui,event_type_t
     return HAL_OK;
 }
 
+/*
+ * changes selected value of selected segment by inc and applies it to the running program
+ */
+static void ui_change_run_value(Ui_HandleTypeDef_t *ui, int16_t inc)
+{
+    firing_segment_t segment = ui->hfiring->segments[run_segment];
+    int32_t value;
+    int32_t max;
+    uint16_t *field;
+
+    //cones step one by one, 0 is a timed hold
+    if(RUN_FIELD_CONE == run_field)
+    {
+        value = (int32_t)segment.cone + ((0 > inc) ? -1 : 1);
+        if(0 <= value && HEATWORK_CONES >= value)
+        {
+            segment.cone = (uint8_t)value;
+            firing_edit_segment(ui->hfiring, run_segment, &segment);
+        }
+        return;
+    }
+
+    switch (run_field) {
+        case RUN_FIELD_GRADIENT:
+            field = &segment.gradient;
+            max = MAX_GRADIENT;
+            break;
+        case RUN_FIELD_TARGET:
+            field = &segment.target;
+            max = MAX_TEMPERATURE;
+            break;
+        case RUN_FIELD_HOLD:
+            field = &segment.hold;
+            max = MAX_HOLD;
+            break;
+        default:
+            return;
+    }
+    value = (int32_t)*field + inc;
+    if(0 > value)
+    {
+        value = 0;
+    }
+    if(max < value)
+    {
+        value = max;
+    }
+    *field = value;
+    firing_edit_segment(ui->hfiring, run_segment, &segment);
+}
+
+/*
+ * updates program_running menu point in SM: dashboard of the running program.
+ * BUT1/2 and encoder select a segment (current or future), ENC_BUT cycles through
+ * gradient, target, hold and finishing cone of it, which BUT1/2 and encoder then change live.
+ * A segment with a cone shows the heat work of the firing in percent of the cone.
+ * BUT4 stops the program
+ */
+static HAL_StatusTypeDef ui_update_program_running(Ui_HandleTypeDef_t *ui,event_type_t event)
+{
+    Firing_HandleTypeDef_t *hfiring = ui->hfiring;
+    uint8_t running = (FIRING_PROGRAM == hfiring->mode);
+
+    switch (event) {
+        case NO_EVENT:  // refresh dashboard
+
+            break;
+        case BUT1:      // navigate left / down
+        case ENC_DOWN:
+            if(RUN_FIELD_NONE != run_field)
+            {
+                ui_change_run_value(ui, (event == BUT1)? -BUTTON_INC : -ENC_INC);
+            }
+            else if(run_segment > hfiring->segment)
+            {
+                run_segment--;
+            }
+            break;
+        case BUT2:      // navigate right / up
+        case ENC_UP:
+            if(RUN_FIELD_NONE != run_field)
+            {
+                ui_change_run_value(ui, (event == BUT2)? BUTTON_INC : ENC_INC);
+            }
+            else if(run_segment + 1 < hfiring->length)
+            {
+                run_segment++;
+            }
+            break;
+        case BUT3:      // navigate back, program keeps running
+            run_field = RUN_FIELD_NONE;
+            ui->state = PROGRAMS;
+            break;
+        case BUT4:      // start / stop
+            if(running)
+            {
+                firing_stop(hfiring);
+            }
+            run_field = RUN_FIELD_NONE;
+            ui->state = PROGRAMS_OVERVIEW;
+            break;
+        case ENC_BUT:   // Enter
+            run_field = running ? (run_field + 1) % RUN_FIELD_COUNT : RUN_FIELD_NONE;
+            break;
+        default:        // unknown event
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
+            return HAL_ERROR;
+    }
+    if(PROGRAM_RUNNING != ui->state)
+    {
+        return HAL_OK;
+    }
+
+    char text_buf_top[UI_LCD_CHAR_SIZE];
+    char text_buf_bottom[UI_LCD_CHAR_SIZE];
+    int temperature = (int)hfiring->hheater->last_temperature;
+    if(!running && NULL != hfiring->hstats)
+    {
+        //summary of the firing: energy, faults, mean and max tracking error, overshoot
+        firestats_summary_t *summary = &hfiring->hstats->last;
+        snprintf(text_buf_top, sizeof(text_buf_top), "DONE %3u.%1ukWh F%-2u", summary->energy / 1000U,
+                (summary->energy % 1000U) / 100U, summary->faults);
+        snprintf(text_buf_bottom, sizeof(text_buf_bottom), "E%+5.1f M%3u O%3u", summary->mean_error / 16.0f,
+                summary->max_error / 16U, summary->overshoot / 16U);
+        ui_print_lcd(ui, text_buf_top, text_buf_bottom);
+        return HAL_OK;
+    }
+    if(!running)
+    {
+        snprintf(text_buf_bottom, sizeof(text_buf_bottom), "IS:  %4d C      ", temperature);
+        ui_print_lcd(ui, "  PROGRAM DONE  ", text_buf_bottom);
+        return HAL_OK;
+    }
+
+    //current segment moves on while the view is open
+    if(run_segment < hfiring->segment)
+    {
+        run_segment = hfiring->segment;
+    }
+    firing_segment_t *segment = &hfiring->segments[run_segment];
+    uint32_t remaining = firing_get_remaining(hfiring) / 60;
+    snprintf(text_buf_top, sizeof(text_buf_top), "S%u/%u%c%4dC %2u:%02u", run_segment + 1, hfiring->length,
+            (run_segment == hfiring->segment)? '*' : ' ', temperature, (unsigned int)(remaining / 60), (unsigned int)(remaining % 60));
+    snprintf(text_buf_bottom, sizeof(text_buf_bottom), "%c%4u %c%4u %c%3u",
+            (RUN_FIELD_GRADIENT == run_field)? '>' : ' ', segment->gradient,
+            (RUN_FIELD_TARGET == run_field)? '>' : ' ', segment->target,
+            (RUN_FIELD_HOLD == run_field)? '>' : ' ', segment->hold);
+    if(RUN_FIELD_CONE == run_field || (RUN_FIELD_NONE == run_field && 0 != segment->cone))
+    {
+        snprintf(text_buf_bottom, sizeof(text_buf_bottom), "%cCONE %-3s %3u%%  ",
+                (RUN_FIELD_CONE == run_field)? '>' : ' ', heatwork_cone_name(segment->cone),
+                heatwork_get_progress(&hfiring->heatwork, segment->cone));
+    }
+    //load is measured before the first segment, values can be edited after
+    if(hfiring->estimating && RUN_FIELD_NONE == run_field)
+    {
+        snprintf(text_buf_bottom, sizeof(text_buf_bottom), "LOAD TEST  L%u   ", hfiring->hheater->heater_level);
+    }
+    ui_print_lcd(ui, text_buf_top, text_buf_bottom);
+
+    return HAL_OK;
+}
+
+/*
+ * changes target of hold mode by inc, applies it live if hold is running
+ */
+static void ui_change_setpoint_target(Ui_HandleTypeDef_t *ui, int16_t inc)
+{
+    //the target of a running program belongs to its segments
+    if(FIRING_PROGRAM == ui->hfiring->mode)
+    {
+        return;
+    }
+    int32_t target = (int32_t)setpoint_target + inc;
+    if(0 > target)
+    {
+        target = 0;
+    }
+    if(MAX_TEMPERATURE < target)
+    {
+        target = MAX_TEMPERATURE;
+    }
+    setpoint_target = target;
+
+    if(FIRING_HOLD == ui->hfiring->mode)
+    {
+        firing_set_target(ui->hfiring, setpoint_target);
+    }
+}
+
+/*
+ * updates setpoint_detailed menu point in SM: dashboard of hold mode,
+ * buttons and encoder adjust the target, BUT4 starts / stops the hold,
+ * ENC_BUT starts / stops a frequency response measurement while holding.
+ * While a program runs the dashboard only shows it, the program screen controls it
+ */
+static HAL_StatusTypeDef ui_update_setpoint_detailed(Ui_HandleTypeDef_t *ui,event_type_t event)
+{
+    switch (event) {
+        case NO_EVENT:  // refresh dashboard
+
+            break;
+        case BUT1:      // navigate left / down
+            ui_change_setpoint_target(ui, -BUTTON_INC);
+            break;
+        case BUT2:      // navigate right / up
+            ui_change_setpoint_target(ui, BUTTON_INC);
+            break;
+        case BUT3:      // navigate back, hold keeps running
+            ui->state = SETPOINT;
+            break;
+        case BUT4:      // start / stop
+            if(FIRING_HOLD == ui->hfiring->mode)
+            {
+                sysid_stop(ui->hsysid);
+                firing_stop(ui->hfiring);
+            }
+            else if(FIRING_IDLE == ui->hfiring->mode)
+            {
+                firing_start_hold(ui->hfiring, setpoint_target, ui->settings.setting_list[4].value,
+                        ui->settings.setting_list[5].value, ui->settings.setting_list[6].value);
+            }
+            break;
+        case ENC_BUT:   // Enter
+            if(sysid_is_running(ui->hsysid))
+            {
+                sysid_stop(ui->hsysid);
+            }
+            else if(FIRING_HOLD == ui->hfiring->mode)
+            {
+                sysid_start(ui->hsysid);
+            }
+            break;
+        case ENC_UP:    // navigate right / up
+            ui_change_setpoint_target(ui, ENC_INC);
+            break;
+        case ENC_DOWN:  // navigate left / down
+            ui_change_setpoint_target(ui, -ENC_INC);
+            break;
+        default:        // unknown event
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
+            return HAL_ERROR;
+    }
+    if(SETPOINT_DETAILED != ui->state)
+    {
+        return HAL_OK;
+    }
+
+    Heater_HandleTypeDef_t *hheater = ui->hfiring->hheater;
+    char text_buf_top[UI_LCD_CHAR_SIZE];
+    char text_buf_bottom[UI_LCD_CHAR_SIZE];
+    const char *run_state = "OFF";
+    if(sysid_is_running(ui->hsysid))
+    {
+        run_state = "ID ";
+    }
+    else if(FIRING_HOLD == ui->hfiring->mode)
+    {
+        run_state = "ON ";
+    }
+    else if(FIRING_PROGRAM == ui->hfiring->mode)
+    {
+        run_state = "PRG";
+    }
+    snprintf(text_buf_top, sizeof(text_buf_top), "SET: %4u C  %s",setpoint_target, run_state);
+    snprintf(text_buf_bottom, sizeof(text_buf_bottom), "IS:  %4d C  L%u ",(int)hheater->last_temperature,
+            hheater->heater_level);
+    ui_print_lcd(ui, text_buf_top, text_buf_bottom);
+
+    lcd1602_setCursor(ui->hlcd, 9, 0);
+    lcd1602_write_char(ui->hlcd, 0);
+    lcd1602_setCursor(ui->hlcd, 9, 1);
+    lcd1602_write_char(ui->hlcd, 0);
+
+    return HAL_OK;
+}
+
 /*
  * updates setpoint menu point in SM
  */
@@ -714,7 +1005,7 @@ static HAL_StatusTypeDef ui_update_setpoint(Ui_HandleTypeDef_t *ui,event_type_t
 
             break;
         case ENC_BUT:   // Enter
-            //TODO choose
+            ui->state = SETPOINT_DETAILED;
             break;
         case ENC_UP:    // navigate right / up
             ui->state = SETTINGS;
@@ -723,9 +1014,7 @@ static HAL_StatusTypeDef ui_update_setpoint(Ui_HandleTypeDef_t *ui,event_type_t
             ui->state = PROGRAMS;
             break;
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
 
@@ -765,9 +1054,7 @@ static HAL_StatusTypeDef ui_update_settings(Ui_HandleTypeDef_t *ui,event_type_t
             ui->state = SETPOINT;
             break;
         default:        // unknown event
-#ifdef UI_ENABLE_LOG
-            logMsg(LOG_ERROR, "unknown event: %u", event);
-#endif
+            LOG_MSG(LOG_ERROR, "unknown event: %u", event);
             return HAL_ERROR;
     }
 
@@ -797,10 +1084,14 @@ HAL_StatusTypeDef ui_update(Ui_HandleTypeDef_t *ui)
 {
     event_type_t cur_event = ui_get_events(ui);
 
-    //no change
+    //no change, the hold dashboard also redraws when the firing has new values
     if(ui->last_state == ui->state && cur_event == NO_EVENT)
     {
-        return HAL_OK;
+        if((SETPOINT_DETAILED != ui->state && PROGRAM_RUNNING != ui->state)
+                || !firing_take_dashboard_update(ui->hfiring))
+        {
+            return HAL_OK;
+        }
     }
     ui->last_state = ui->state;
 
@@ -837,6 +1128,14 @@ HAL_StatusTypeDef ui_update(Ui_HandleTypeDef_t *ui)
             return ui_update_create_program_detailed(ui, cur_event);
             break;
 
+        case SETPOINT_DETAILED:
+            return ui_update_setpoint_detailed(ui, cur_event);
+            break;
+
+        case PROGRAM_RUNNING:
+            return ui_update_program_running(ui, cur_event);
+            break;
+
         default:
             return HAL_OK;
             break;
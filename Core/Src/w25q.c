@@ -0,0 +1,233 @@
+/*
+ * w25q.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Dennis Rathgeb
+ */
+
+#include "w25q.h"
+
+/*
+ * pulls chip select and takes the bus, HAL_BUSY if the bus is in use
+ */
+static HAL_StatusTypeDef w25q_select(W25Q_HandleTypeDef_t* hflash)
+{
+    if(HAL_OK != spibus_acquire(hflash->hbus, SPIBUS_DEVICE_FLASH))
+    {
+        return HAL_BUSY;
+    }
+    HAL_GPIO_WritePin(FLASH_NSS_GPIO_Port, FLASH_NSS_Pin, GPIO_PIN_RESET);
+    return HAL_OK;
+}
+
+static void w25q_deselect(W25Q_HandleTypeDef_t* hflash)
+{
+    HAL_GPIO_WritePin(FLASH_NSS_GPIO_Port, FLASH_NSS_Pin, GPIO_PIN_SET);
+    spibus_release(hflash->hbus, SPIBUS_DEVICE_FLASH);
+}
+
+/*
+ * sends command with 24 bit address in one chip select cycle
+ */
+static HAL_StatusTypeDef w25q_command(W25Q_HandleTypeDef_t* hflash, uint8_t cmd, uint32_t addr)
+{
+    uint8_t buf[4] = {cmd, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+    if(HAL_OK != w25q_select(hflash))
+    {
+        return HAL_BUSY;
+    }
+    HAL_StatusTypeDef status = HAL_SPI_Transmit(hflash->hbus->hspi, buf, sizeof(buf), W25Q_TIMEOUT);
+    w25q_deselect(hflash);
+    return status;
+}
+
+static HAL_StatusTypeDef w25q_write_enable(W25Q_HandleTypeDef_t* hflash)
+{
+    uint8_t cmd = W25Q_CMD_WRITE_ENABLE;
+    if(HAL_OK != w25q_select(hflash))
+    {
+        return HAL_BUSY;
+    }
+    HAL_StatusTypeDef status = HAL_SPI_Transmit(hflash->hbus->hspi, &cmd, 1, W25Q_TIMEOUT);
+    w25q_deselect(hflash);
+    return status;
+}
+
+/*
+ * flashlog device callbacks
+ */
+static HAL_StatusTypeDef w25q_dev_read(void* ctx, uint32_t addr, uint8_t* data, uint16_t len)
+{
+    return w25q_read((W25Q_HandleTypeDef_t*)ctx, addr, data, len);
+}
+
+static HAL_StatusTypeDef w25q_dev_program(void* ctx, uint32_t addr, const uint8_t* data, uint16_t len)
+{
+    return w25q_program((W25Q_HandleTypeDef_t*)ctx, addr, data, len);
+}
+
+static HAL_StatusTypeDef w25q_dev_erase(void* ctx, uint32_t addr, uint32_t len)
+{
+    return w25q_erase((W25Q_HandleTypeDef_t*)ctx, addr, len);
+}
+
+static uint8_t w25q_dev_is_busy(void* ctx)
+{
+    return w25q_is_busy((W25Q_HandleTypeDef_t*)ctx);
+}
+
+/*
+ * init function of flash instance, reads capacity from JEDEC id
+ */
+HAL_StatusTypeDef initW25q(W25Q_HandleTypeDef_t* hflash, Spibus_HandleTypeDef_t* hbus)
+{
+    uint8_t cmd = W25Q_CMD_JEDEC_ID;
+    uint8_t id[3] = {0};
+
+    if(NULL == hflash || NULL == hbus)
+    {
+        return HAL_ERROR;
+    }
+    hflash->hbus = hbus;
+    hflash->busy = 0;
+    hflash->size = 0;
+    HAL_GPIO_WritePin(FLASH_NSS_GPIO_Port, FLASH_NSS_Pin, GPIO_PIN_SET);
+
+    if(HAL_OK != w25q_select(hflash))
+    {
+        return HAL_BUSY;
+    }
+    HAL_StatusTypeDef status = HAL_SPI_Transmit(hbus->hspi, &cmd, 1, W25Q_TIMEOUT);
+    if(HAL_OK == status)
+    {
+        status = HAL_SPI_Receive(hbus->hspi, id, sizeof(id), W25Q_TIMEOUT);
+    }
+    w25q_deselect(hflash);
+
+    //id[2] is log2 of the capacity, 0x14 (1MB) up to 0x18 (16MB) with 24 bit addresses
+    if(HAL_OK != status || W25Q_MANUFACTURER_ID != id[0] || 0x14 > id[2] || 0x18 < id[2])
+    {
+        return HAL_ERROR;
+    }
+    hflash->size = 1UL << id[2];
+
+    hflash->dev.ctx = hflash;
+    hflash->dev.size = hflash->size;
+    hflash->dev.read = w25q_dev_read;
+    hflash->dev.program = w25q_dev_program;
+    hflash->dev.erase = w25q_dev_erase;
+    hflash->dev.is_busy = w25q_dev_is_busy;
+    return HAL_OK;
+}
+
+/*
+ * reads len bytes, the chip streams across page and sector boundaries
+ */
+HAL_StatusTypeDef w25q_read(W25Q_HandleTypeDef_t* hflash, uint32_t addr, uint8_t* data, uint16_t len)
+{
+    uint8_t buf[4] = {W25Q_CMD_READ_DATA, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+    if(hflash->busy || HAL_OK != w25q_select(hflash))
+    {
+        return HAL_BUSY;
+    }
+    HAL_StatusTypeDef status = HAL_SPI_Transmit(hflash->hbus->hspi, buf, sizeof(buf), W25Q_TIMEOUT);
+    if(HAL_OK == status)
+    {
+        status = HAL_SPI_Receive(hflash->hbus->hspi, data, len, W25Q_TIMEOUT);
+    }
+    w25q_deselect(hflash);
+    return status;
+}
+
+/*
+ * starts programming len bytes, must not cross a page boundary
+ */
+HAL_StatusTypeDef w25q_program(W25Q_HandleTypeDef_t* hflash, uint32_t addr, const uint8_t* data, uint16_t len)
+{
+    uint8_t buf[4] = {W25Q_CMD_PAGE_PROGRAM, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+    if((addr % FLASHLOG_PAGE_SIZE) + len > FLASHLOG_PAGE_SIZE)
+    {
+        return HAL_ERROR;
+    }
+    if(hflash->busy || HAL_OK != w25q_write_enable(hflash))
+    {
+        return HAL_BUSY;
+    }
+    if(HAL_OK != w25q_select(hflash))
+    {
+        return HAL_BUSY;
+    }
+    HAL_StatusTypeDef status = HAL_SPI_Transmit(hflash->hbus->hspi, buf, sizeof(buf), W25Q_TIMEOUT);
+    if(HAL_OK == status)
+    {
+        status = HAL_SPI_Transmit(hflash->hbus->hspi, (uint8_t*)data, len, W25Q_TIMEOUT);
+    }
+    w25q_deselect(hflash);
+    if(HAL_OK == status)
+    {
+        hflash->busy = 1;
+    }
+    return status;
+}
+
+/*
+ * starts erasing a 4K sector or 64K block, addr aligned to len
+ */
+HAL_StatusTypeDef w25q_erase(W25Q_HandleTypeDef_t* hflash, uint32_t addr, uint32_t len)
+{
+    uint8_t cmd;
+    if(FLASHLOG_SECTOR_SIZE == len)
+    {
+        cmd = W25Q_CMD_SECTOR_ERASE;
+    }
+    else if(FLASHLOG_BLOCK_SIZE == len)
+    {
+        cmd = W25Q_CMD_BLOCK_ERASE;
+    }
+    else
+    {
+        return HAL_ERROR;
+    }
+    if(0 != addr % len || hflash->size <= addr)
+    {
+        return HAL_ERROR;
+    }
+    if(hflash->busy || HAL_OK != w25q_write_enable(hflash))
+    {
+        return HAL_BUSY;
+    }
+    HAL_StatusTypeDef status = w25q_command(hflash, cmd, addr);
+    if(HAL_OK == status)
+    {
+        hflash->busy = 1;
+    }
+    return status;
+}
+
+/*
+ * returns 1 while a program or erase runs, only reads the status register then
+ */
+uint8_t w25q_is_busy(W25Q_HandleTypeDef_t* hflash)
+{
+    uint8_t buf[2] = {W25Q_CMD_READ_STATUS1, 0};
+    if(!hflash->busy)
+    {
+        return 0;
+    }
+    if(HAL_OK != w25q_select(hflash))
+    {
+        return 1;
+    }
+    HAL_StatusTypeDef status = HAL_SPI_TransmitReceive(hflash->hbus->hspi, buf, buf, sizeof(buf), W25Q_TIMEOUT);
+    w25q_deselect(hflash);
+    if(HAL_OK == status && !(buf[1] & W25Q_STATUS_BUSY))
+    {
+        hflash->busy = 0;
+    }
+    return hflash->busy;
+}
+
+const flashlog_device_t* w25q_get_device(W25Q_HandleTypeDef_t* hflash)
+{
+    return &hflash->dev;
+}